@@ -0,0 +1,205 @@
+// Stub FastCGI responder standing in for php-fpm when testing the server's FastCGI client.
+// Answers every request with a fixed-size HTML body split into several FCGI_STDOUT records,
+// honours FCGI_KEEP_CONN and answers FCGI_GET_VALUES, optionally allowing multiplexing.
+// Prints the number of connections and requests every second, so connection reuse is visible.
+//
+// Usage: FastCgiStub [address] [single|mpx] [bytes] [delay ms]
+//   address is host:port (default 127.0.0.1:9000) or a unix socket path
+// Then point a project at it, e.g. "PhpFastCgi 127.0.0.1:9000" in its .htaccess.
+#include "Network/FastCgi.h"
+#include <boost/asio.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+    using Network::FastCgi;
+
+    struct Options {
+        std::string address = "127.0.0.1:9000";
+        bool multiplex = false;
+        std::size_t bytes = 4096;
+        std::chrono::milliseconds delay{0};
+    };
+
+    std::atomic<std::uint64_t> connections{0};
+    std::atomic<std::uint64_t> requests{0};
+
+    template <typename Socket>
+    class Session : public std::enable_shared_from_this<Session<Socket>> {
+    public:
+        Session(Socket socket, const Options& options) : socket_(std::move(socket)), options_(options), buffer_(64 * 1024, '\0') {}
+
+        void start() { doRead(); }
+
+    private:
+        struct Request {
+            std::string params;
+            bool keepConnection = false;
+        };
+
+        void doRead() {
+            socket_.async_read_some(boost::asio::buffer(buffer_.data() + buffered_, buffer_.size() - buffered_),
+                                    [self = this->shared_from_this()](const boost::system::error_code& error, std::size_t size) {
+                if (error) {
+                    return;
+                }
+                self->buffered_ += size;
+                self->onRecords();
+                self->doRead();
+            });
+        }
+
+        void onRecords() {
+            std::string_view data(buffer_.data(), buffered_);
+            FastCgi::Record record;
+            while (FastCgi::nextRecord(data, record)) {
+                if (record.type == FastCgi::GetValues) {
+                    std::vector<std::pair<std::string, std::string>> names;
+                    FastCgi::parseParams(record.content, names);
+                    std::string content;
+                    for (const auto& [name, ignored] : names) {
+                        std::string value = name == "FCGI_MPXS_CONNS" ? (options_.multiplex ? "1" : "0")
+                                          : name == "FCGI_MAX_REQS" ? "32" : "";
+                        if (value.empty()) continue;
+                        content += static_cast<char>(name.size()); // Short names and values use one length byte
+                        content += static_cast<char>(value.size());
+                        content += name + value;
+                    }
+                    std::string out;
+                    FastCgi::appendRecord(out, FastCgi::GetValuesResult, 0, content);
+                    send(std::move(out));
+                } else if (record.type == FastCgi::BeginRequest) {
+                    requests_[record.requestId].keepConnection = record.content.size() > 2 && (record.content[2] & 1);
+                } else if (record.type == FastCgi::Params) {
+                    requests_[record.requestId].params.append(record.content);
+                } else if (record.type == FastCgi::Stdin && record.content.empty()) {
+                    respond(record.requestId);
+                }
+            }
+            std::size_t consumed = buffered_ - data.size();
+            std::memmove(buffer_.data(), buffer_.data() + consumed, data.size());
+            buffered_ = data.size();
+        }
+
+        void respond(std::uint16_t requestId) {
+            auto timer = std::make_shared<boost::asio::steady_timer>(socket_.get_executor(), options_.delay);
+            timer->async_wait([self = this->shared_from_this(), timer, requestId](const boost::system::error_code&) {
+                std::vector<std::pair<std::string, std::string>> params;
+                FastCgi::parseParams(self->requests_[requestId].params, params);
+                std::string uri;
+                for (const auto& [name, value] : params) {
+                    if (name == "REQUEST_URI") uri = value;
+                }
+                std::string output = "Content-Type: text/html\r\n\r\n<p>" + uri + "</p>";
+                output.resize(std::max(output.size(), self->options_.bytes), '.');
+
+                // Several records per response, as php-fpm flushes its output buffer
+                std::string out;
+                for (std::size_t offset = 0; offset < output.size(); offset += 8192) {
+                    FastCgi::appendRecord(out, FastCgi::Stdout, requestId, std::string_view(output).substr(offset, 8192));
+                }
+                FastCgi::appendRecord(out, FastCgi::Stdout, requestId, {});
+                FastCgi::appendEndRequest(out, requestId, 0);
+                bool close = !self->requests_[requestId].keepConnection;
+                self->requests_.erase(requestId);
+                ++requests;
+                self->send(std::move(out), close);
+            });
+        }
+
+        // Writes are queued, multiplexed responses must not interleave on the socket
+        void send(std::string data, bool close = false) {
+            writes_.emplace_back(std::move(data), close);
+            if (writes_.size() == 1) {
+                doWrite();
+            }
+        }
+
+        void doWrite() {
+            boost::asio::async_write(socket_, boost::asio::buffer(writes_.front().first),
+                                     [self = this->shared_from_this()](const boost::system::error_code& error, std::size_t) {
+                bool close = self->writes_.front().second;
+                self->writes_.pop_front();
+                if (error || close) {
+                    boost::system::error_code ec;
+                    self->socket_.close(ec);
+                    return;
+                }
+                if (!self->writes_.empty()) {
+                    self->doWrite();
+                }
+            });
+        }
+
+        Socket socket_;
+        const Options& options_;
+        std::string buffer_;
+        std::size_t buffered_ = 0;
+        std::map<std::uint16_t, Request> requests_;
+        std::deque<std::pair<std::string, bool>> writes_; // Data and whether to close afterwards
+    };
+
+    template <typename Acceptor>
+    void doAccept(Acceptor& acceptor, const Options& options) {
+        acceptor.async_accept([&acceptor, &options](const boost::system::error_code& error, auto socket) {
+            if (!error) {
+                ++connections;
+                std::make_shared<Session<decltype(socket)>>(std::move(socket), options)->start();
+            }
+            doAccept(acceptor, options);
+        });
+    }
+
+    void report(boost::asio::steady_timer& timer) {
+        timer.expires_after(std::chrono::seconds(1));
+        timer.async_wait([&timer](const boost::system::error_code& error) {
+            if (error) return;
+            std::printf("connections %llu, requests %llu\n", static_cast<unsigned long long>(connections.load()),
+                        static_cast<unsigned long long>(requests.load()));
+            std::fflush(stdout);
+            report(timer);
+        });
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (argc > 1) options.address = argv[1];
+    if (argc > 2) options.multiplex = std::string(argv[2]) == "mpx";
+    if (argc > 3) options.bytes = std::stoull(argv[3]);
+    if (argc > 4) options.delay = std::chrono::milliseconds(std::stoll(argv[4]));
+
+    boost::asio::io_context ioContext;
+    boost::asio::steady_timer timer(ioContext);
+    report(timer);
+
+    if (options.address.starts_with('/')) {
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+        std::remove(options.address.c_str());
+        boost::asio::local::stream_protocol::acceptor acceptor(ioContext, boost::asio::local::stream_protocol::endpoint(options.address));
+        doAccept(acceptor, options);
+        std::printf("FastCGI stub on %s (%s)\n", options.address.c_str(), options.multiplex ? "multiplexed" : "one request per connection");
+        ioContext.run();
+#else
+        std::printf("unix sockets are not supported on this platform\n");
+        return 1;
+#endif
+    } else {
+        auto colon = options.address.rfind(':');
+        boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::make_address(options.address.substr(0, colon)),
+                                                static_cast<unsigned short>(std::stoi(options.address.substr(colon + 1))));
+        boost::asio::ip::tcp::acceptor acceptor(ioContext, endpoint);
+        doAccept(acceptor, options);
+        std::printf("FastCGI stub on %s (%s)\n", options.address.c_str(), options.multiplex ? "multiplexed" : "one request per connection");
+        ioContext.run();
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+// Microbenchmark: requests parsed per second by Network::HttpParser (for every
+// HttpScan kernel the CPU supports) versus the previous streambuf -> stringstream ->
+// getline/substr request handling.
+#include "Network/HttpParser.h"
+#include "Network/HttpScan.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+namespace {
+
+    const std::string sampleRequest =
+            "GET /assets/css/main.css?v=20240101 HTTP/1.1\r\n"
+            "Host: localhost:8080\r\n"
+            "User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/124.0.0.0 Safari/537.36\r\n"
+            "Accept: text/css,*/*;q=0.1\r\n"
+            "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+            "Accept-Language: en-US,en;q=0.9,de;q=0.8\r\n"
+            "Cache-Control: no-cache\r\n"
+            "Connection: keep-alive\r\n"
+            "Cookie: session=8f14e45fceea167a5a36dedd4bea2543; theme=dark; _ga=GA1.1.123456789.1700000000; _gid=GA1.1.987654321.1700000000\r\n"
+            "Referer: http://localhost:8080/index.html\r\n"
+            "Sec-Fetch-Dest: style\r\n"
+            "Sec-Fetch-Mode: no-cors\r\n"
+            "Sec-Fetch-Site: same-origin\r\n"
+            "\r\n";
+
+    // Request line and header handling as done before the dedicated parser
+    std::size_t legacyParse(const std::string& raw) {
+        std::stringstream requestStream;
+        requestStream << raw;
+
+        std::string requestLine;
+        std::getline(requestStream, requestLine);
+        std::string method = requestLine.substr(0, requestLine.find(' '));
+        std::string path = requestLine.substr(requestLine.find(' ') + 1,
+                                              requestLine.find(' ', requestLine.find(' ') + 1) - requestLine.find(' ') - 1);
+        bool keepAlive = requestLine.find("HTTP/1.1") != std::string::npos;
+        std::string line;
+        while (std::getline(requestStream, line) && line != "\r" && !line.empty()) {
+            std::string lower = line;
+            std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+            if (lower.starts_with("connection:") && lower.find("close") != std::string::npos) keepAlive = false;
+        }
+        return method.size() + path.size() + keepAlive;
+    }
+
+    std::size_t parserParse(Network::HttpParser& parser, Network::HttpRequest& request, std::string_view raw, std::size_t chunks) {
+        // Feed the request in pieces to exercise the incremental path
+        std::size_t step = raw.size() / chunks;
+        for (std::size_t end = step; end < raw.size(); end += step) {
+            if (parser.parse(raw.substr(0, end), request) == Network::HttpParser::Result::Complete) break;
+        }
+        if (parser.parse(raw, request) != Network::HttpParser::Result::Complete) return 0;
+        std::size_t result = request.method.size() + request.path().size() + request.keepAlive();
+        parser.reset();
+        return result;
+    }
+
+    template <typename Function>
+    void run(const char* name, std::size_t iterations, Function&& function) {
+        std::size_t sink = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < iterations; ++i) {
+            sink += function();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        std::printf("%-36s %12.0f requests/s  (%.1f ns/request, checksum %zu)\n",
+                    name, iterations / elapsed.count(), elapsed.count() * 1e9 / iterations, sink);
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::size_t iterations = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    std::printf("Request head: %zu bytes, %zu iterations\n", sampleRequest.size(), iterations);
+
+    // Browser request carrying a large cookie jar
+    std::string cookieRequest = sampleRequest;
+    cookieRequest.insert(cookieRequest.size() - 2, "Cookie: consent=" + std::string(3000, 'x') + "; prefs=" + std::string(1000, 'y') + "\r\n");
+
+    Network::HttpParser parser;
+    Network::HttpRequest request;
+    run("legacy stringstream/getline", iterations, [&]() { return legacyParse(sampleRequest); });
+    run("legacy, 4 KB cookies", iterations, [&]() { return legacyParse(cookieRequest); });
+
+    using Network::HttpScan;
+    for (auto implementation : {HttpScan::Implementation::Scalar, HttpScan::Implementation::SSE42, HttpScan::Implementation::AVX2}) {
+        HttpScan::setImplementation(implementation);
+        if (HttpScan::implementation() != implementation) continue; // Not supported by this CPU
+        std::string name = std::string("HttpParser ") + HttpScan::name(implementation);
+        run((name + ", one read").c_str(), iterations, [&]() { return parserParse(parser, request, sampleRequest, 1); });
+        run((name + ", four reads").c_str(), iterations, [&]() { return parserParse(parser, request, sampleRequest, 4); });
+        run((name + ", 4 KB cookies").c_str(), iterations, [&]() { return parserParse(parser, request, cookieRequest, 1); });
+    }
+    return 0;
+}
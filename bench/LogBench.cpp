@@ -0,0 +1,107 @@
+// Microbenchmark: logging cost per request on the request thread. A request logs the
+// lines a static file request produces; compared are the previous synchronous Debug::Log
+// (ctime, global mutex, console endl, reopening app_logs.txt per line), the queued logger
+// with the lines enabled, and with the Debug level switched off at runtime, once through
+// the LOG_* macros and once through eagerly formatted Log::debug calls.
+// The logger writes to the console, run with stdout redirected: LogBench > /dev/null
+#include "Debug/Log.h"
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+namespace {
+
+    // Stands in for std::cout in the legacy logger
+    struct NullBuffer : std::streambuf {
+        int overflow(int c) override { return c; }
+    };
+    NullBuffer nullBuffer;
+    std::ostream nullStream(&nullBuffer);
+
+    std::mutex legacyMutex;
+
+    // Debug::Log::log as it was before the writer thread
+    void legacyLog(const std::string& prefix, const std::string& message, const std::string& file) {
+        auto timestamp = [] {
+            auto time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+            std::string ts = std::ctime(&time);
+            ts.pop_back();
+            return ts;
+        };
+        std::string result = std::format("[{}] {} [{}] {}", timestamp(), prefix, file, message);
+        std::lock_guard<std::mutex> guard(legacyMutex);
+        nullStream << result << std::endl;
+        std::ofstream logFile("LogBench_legacy.txt", std::ios::app);
+        if (logFile.is_open()) {
+            logFile << result << std::endl;
+        }
+    }
+
+    const std::string path = "/assets/css/main.css";
+    const std::string contentType = "text/css";
+    const int port = 8080;
+
+    void legacyRequest() {
+        legacyLog("[INFO]", std::format("Accepted connection on port {}", port), "WebServer");
+        legacyLog("[INFO]", "Handling new request", "RequestHandler");
+        legacyLog("[INFO]", std::format("Received {} request for {}", "GET", path), "RequestHandler");
+        legacyLog("[INFO]", std::format("Using MIME type {} for extension {}", contentType, ".css"), "RequestHandler");
+        legacyLog("[INFO]", std::format("Served cached file: {}", path), "RequestHandler");
+    }
+
+    void macroRequest() {
+        LOG_DEBUG("WebServer", "Accepted connection on port {}", port);
+        LOG_DEBUG("RequestHandler", "Handling new request");
+        LOG_DEBUG("RequestHandler", "Received {} request for {}", "GET", path);
+        LOG_DEBUG("RequestHandler", "Using MIME type {} for extension {}", contentType, ".css");
+        LOG_DEBUG("RequestHandler", "Served cached file: {}", path);
+    }
+
+    void eagerRequest() {
+        Debug::Log::debug(std::format("Accepted connection on port {}", port), "WebServer");
+        Debug::Log::debug("Handling new request", "RequestHandler");
+        Debug::Log::debug(std::format("Received {} request for {}", "GET", path), "RequestHandler");
+        Debug::Log::debug(std::format("Using MIME type {} for extension {}", contentType, ".css"), "RequestHandler");
+        Debug::Log::debug(std::format("Served cached file: {}", path), "RequestHandler");
+    }
+
+    template <typename Function>
+    void run(const char* name, std::size_t iterations, Function&& function) {
+        auto begin = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < iterations; ++i) {
+            function();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        std::fprintf(stderr, "%-36s %12.0f requests/s  (%.1f ns/request)\n",
+                     name, iterations / elapsed.count(), elapsed.count() * 1e9 / iterations);
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::size_t iterations = argc > 1 ? std::stoul(argv[1]) : 100000;
+    std::fprintf(stderr, "5 lines per request, %zu iterations\n", iterations);
+
+    run("before: synchronous Log", iterations / 10, legacyRequest);
+
+    // Block so every line is written and counted against the request thread
+    Debug::Log::setOverflowPolicy(Debug::Log::OverflowPolicy::Block);
+    Debug::Log::setLevel(Debug::Log::Level::Debug);
+    run("queued Log, Debug enabled", iterations, macroRequest);
+    Debug::Log::flush();
+
+    Debug::Log::setLevel(Debug::Log::Level::Info);
+    run("Log::debug, Debug disabled", iterations * 10, eagerRequest);
+    run("LOG_DEBUG, Debug disabled", iterations * 10, macroRequest);
+
+    Debug::Log::Stats stats = Debug::Log::getStats();
+    std::fprintf(stderr, "%llu lines written, %llu dropped\n",
+                 static_cast<unsigned long long>(stats.written), static_cast<unsigned long long>(stats.dropped));
+    std::remove("LogBench_legacy.txt");
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,163 @@
+// Benchmark: seek-heavy media playback against a running server. Every seek fetches a
+// window at a random offset of a large file, either with a Range request on a kept-alive
+// connection or, as a client without range support has to, by downloading from byte zero
+// until the window has arrived and dropping the connection.
+//
+// Create the file first, e.g.: head -c 512M /dev/urandom > domains/Example1/video.bin
+#include <boost/asio.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+    using boost::asio::ip::tcp;
+
+    struct Options {
+        std::string host = "127.0.0.1";
+        std::string port = "8080";
+        std::string target = "/video.bin";
+        std::size_t seeks = 200;
+        std::uint64_t window = 2 * 1024 * 1024; // Bytes a player buffers after a seek
+    };
+
+    // Read a response head, returns Content-Length and leaves any body bytes already read in rest
+    std::uint64_t readHead(tcp::socket& socket, std::string& rest, bool* keepAlive = nullptr) {
+        boost::asio::streambuf buffer;
+        std::size_t headSize = boost::asio::read_until(socket, buffer, "\r\n\r\n");
+        std::string data(boost::asio::buffers_begin(buffer.data()), boost::asio::buffers_end(buffer.data()));
+        std::string head = data.substr(0, headSize);
+        rest = data.substr(headSize);
+
+        std::string lower = head;
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+        if (keepAlive) *keepAlive = lower.find("connection: close") == std::string::npos;
+        auto pos = lower.find("content-length:");
+        return pos == std::string::npos ? 0 : std::stoull(head.substr(pos + 15));
+    }
+
+    // Read exactly count body bytes following a head
+    void readBody(tcp::socket& socket, std::uint64_t count, std::uint64_t alreadyRead) {
+        static std::vector<char> sink(256 * 1024);
+        for (std::uint64_t remaining = count - std::min(count, alreadyRead); remaining > 0;) {
+            std::size_t chunk = static_cast<std::size_t>(std::min<std::uint64_t>(remaining, sink.size()));
+            remaining -= boost::asio::read(socket, boost::asio::buffer(sink.data(), chunk));
+        }
+    }
+
+    struct Result {
+        std::vector<double> latencies; // Milliseconds per seek
+        std::uint64_t bytes = 0;
+        double seconds = 0;
+    };
+
+    void report(const char* name, Result& result) {
+        std::sort(result.latencies.begin(), result.latencies.end());
+        auto percentile = [&](double p) {
+            return result.latencies[std::min(result.latencies.size() - 1, static_cast<std::size_t>(p * result.latencies.size()))];
+        };
+        std::printf("%-24s %8.1f seeks/s  p50 %7.2f ms  p99 %7.2f ms  %10.1f MB received\n", name,
+                    result.latencies.size() / result.seconds, percentile(0.5), percentile(0.99), result.bytes / 1048576.0);
+    }
+
+    Result runRanges(boost::asio::io_context& ioContext, const Options& options, const std::vector<std::uint64_t>& offsets,
+                     std::uint64_t size) {
+        Result result;
+        tcp::socket socket(ioContext);
+        bool keepAlive = false;
+        auto begin = std::chrono::steady_clock::now();
+        for (std::uint64_t offset : offsets) {
+            auto start = std::chrono::steady_clock::now();
+            if (!keepAlive) {
+                // Reconnect once the server's MaxKeepAliveRequests is used up
+                socket = tcp::socket(ioContext);
+                boost::asio::connect(socket, tcp::resolver(ioContext).resolve(options.host, options.port));
+            }
+            std::uint64_t last = std::min(size, offset + options.window) - 1;
+            std::string request = "GET " + options.target + " HTTP/1.1\r\nHost: " + options.host
+                                  + "\r\nRange: bytes=" + std::to_string(offset) + "-" + std::to_string(last) + "\r\n\r\n";
+            boost::asio::write(socket, boost::asio::buffer(request));
+            std::string rest;
+            std::uint64_t length = readHead(socket, rest, &keepAlive);
+            readBody(socket, length, rest.size());
+            result.bytes += length;
+            result.latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        return result;
+    }
+
+    Result runFull(boost::asio::io_context& ioContext, const Options& options, const std::vector<std::uint64_t>& offsets,
+                   std::uint64_t size) {
+        Result result;
+        auto begin = std::chrono::steady_clock::now();
+        for (std::uint64_t offset : offsets) {
+            auto start = std::chrono::steady_clock::now();
+            tcp::socket socket(ioContext);
+            boost::asio::connect(socket, tcp::resolver(ioContext).resolve(options.host, options.port));
+            std::string request = "GET " + options.target + " HTTP/1.1\r\nHost: " + options.host + "\r\nConnection: close\r\n\r\n";
+            boost::asio::write(socket, boost::asio::buffer(request));
+            std::string rest;
+            readHead(socket, rest);
+            std::uint64_t needed = std::min(size, offset + options.window);
+            readBody(socket, needed, rest.size());
+            result.bytes += needed;
+            result.latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        return result;
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (argc > 1) options.port = argv[1];
+    if (argc > 2) options.target = argv[2];
+    if (argc > 3) options.seeks = std::stoul(argv[3]);
+    if (argc > 4) options.window = std::stoull(argv[4]);
+
+    try {
+        boost::asio::io_context ioContext;
+
+        // Learn the file size from a one byte range
+        tcp::socket probe(ioContext);
+        boost::asio::connect(probe, tcp::resolver(ioContext).resolve(options.host, options.port));
+        std::string request = "GET " + options.target + " HTTP/1.1\r\nHost: " + options.host + "\r\nRange: bytes=-1\r\nConnection: close\r\n\r\n";
+        boost::asio::write(probe, boost::asio::buffer(request));
+        boost::asio::streambuf buffer;
+        boost::system::error_code ec;
+        boost::asio::read(probe, buffer, ec);
+        std::string response(boost::asio::buffers_begin(buffer.data()), boost::asio::buffers_end(buffer.data()));
+        auto slash = response.find("Content-Range: bytes ");
+        slash = slash == std::string::npos ? slash : response.find('/', slash);
+        if (slash == std::string::npos) {
+            std::fprintf(stderr, "%s does not answer range requests:\n%s\n", options.target.c_str(),
+                         response.substr(0, response.find("\r\n")).c_str());
+            return 1;
+        }
+        std::uint64_t size = std::stoull(response.substr(slash + 1));
+
+        // Same seek positions for both clients
+        std::mt19937_64 generator(42);
+        std::vector<std::uint64_t> offsets(options.seeks);
+        for (auto& offset : offsets) {
+            offset = size > options.window ? generator() % (size - options.window) : 0;
+        }
+        std::printf("%s: %.1f MB, %zu seeks, %.1f MB window\n", options.target.c_str(), size / 1048576.0, options.seeks,
+                    options.window / 1048576.0);
+
+        Result ranges = runRanges(ioContext, options, offsets, size);
+        report("Range, keep-alive", ranges);
+        Result full = runFull(ioContext, options, offsets, size);
+        report("from byte zero", full);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
@@ -1,44 +1,400 @@
 #include "Log.h"
-#include <fstream>
+#include "LogBuffer.h"
+#include "MpscRing.h"
+#include "../System/Clock.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <format>
 #include <iostream>
+#include <thread>
+#if ENABLE_LOGGING
+#include <memory>
+#include <unordered_map>
+#include <spdlog/async.h>
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/details/periodic_worker.h>
+#include <spdlog/sinks/base_sink.h>
+#include <spdlog/sinks/rotating_file_sink.h>
+#include <spdlog/sinks/stdout_sinks.h>
+#endif
 
 namespace Debug {
 
-    std::vector<std::string> Log::logs;
-    std::mutex Log::mutex_;
+    namespace {
 
-    std::string Log::getTimestamp() {
-        auto now = std::chrono::system_clock::now();
-        auto time = std::chrono::system_clock::to_time_t(now);
-        std::string ts = std::ctime(&time);
-        ts.pop_back(); // Remove newline
-        return ts;
-    }
+        constexpr std::size_t QUEUE_CAPACITY = 8192;
+        constexpr std::size_t BUFFER_CAPACITY = 10000; // Lines kept for the GUI
+
+        std::atomic<Log::OverflowPolicy> overflowPolicy{Log::OverflowPolicy::CountAndDrop};
+        std::atomic<std::uint64_t> written{0};
+        std::atomic<std::uint64_t> dropped{0};
+        std::atomic<std::uint64_t> unreported{0}; // Dropped lines not yet reported in the log
+        std::atomic<bool> writerGone{false}; // Set at exit once the writer thread is joined
+
+        using Record = LogBuffer::Record;
+
+        LogBuffer& buffer() {
+            static LogBuffer instance(BUFFER_CAPACITY);
+            return instance;
+        }
+
+#if ENABLE_LOGGING
+        constexpr std::size_t ROTATE_SIZE = 10 * 1024 * 1024; // Bytes per log file
+        constexpr std::size_t ROTATE_FILES = 3; // Rotated files kept next to app_logs.txt
+        constexpr auto FLUSH_TIMEOUT = std::chrono::seconds(5);
+
+        spdlog::level::level_enum toSpdlog(Log::Level level) {
+            switch (level) {
+                case Log::Level::Debug: return spdlog::level::debug;
+                case Log::Level::Info: return spdlog::level::info;
+                case Log::Level::Warning: return spdlog::level::warn;
+                case Log::Level::Error: return spdlog::level::err;
+            }
+            return spdlog::level::info;
+        }
+
+        Log::Level fromSpdlog(spdlog::level::level_enum level) {
+            switch (level) {
+                case spdlog::level::trace:
+                case spdlog::level::debug: return Log::Level::Debug;
+                case spdlog::level::info: return Log::Level::Info;
+                case spdlog::level::warn: return Log::Level::Warning;
+                default: return Log::Level::Error;
+            }
+        }
+
+        // Feeds the GUI buffer on the spdlog thread, the logger name is the source
+        class GuiSink : public spdlog::sinks::base_sink<std::mutex> {
+        public:
+            explicit GuiSink(LogBuffer& buffer) : buffer_(buffer) {}
+
+        protected:
+            void sink_it_(const spdlog::details::log_msg& msg) override {
+                spdlog::memory_buf_t formatted;
+                formatter_->format(msg, formatted);
+                std::size_t size = formatted.size();
+                while (size > 0 && (formatted[size - 1] == '\n' || formatted[size - 1] == '\r')) --size;
+
+                records_.resize(1);
+                records_[0].level = fromSpdlog(msg.level);
+                records_[0].source.assign(msg.logger_name.data(), msg.logger_name.size());
+                records_[0].text.assign(formatted.data(), size);
+                buffer_.append(records_);
+                records_.clear();
+            }
+
+            void flush_() override {}
+
+        private:
+            LogBuffer& buffer_;
+            std::vector<Record> records_;
+        };
+
+        // Placed after the other sinks, counts the lines they are done with for flush()
+        class CompletionSink : public spdlog::sinks::base_sink<spdlog::details::null_mutex> {
+        protected:
+            void sink_it_(const spdlog::details::log_msg&) override {
+                written.fetch_add(1, std::memory_order_release);
+            }
+
+            void flush_() override {}
+        };
+
+        // Hands lines to spdlog's thread pool. Every source gets its own async logger named after
+        // it, all sharing the console, rotating file and GUI sinks
+        class SpdlogWriter {
+        public:
+            SpdlogWriter() : pool_(std::make_shared<spdlog::details::thread_pool>(QUEUE_CAPACITY, 1)) {
+                sinks_.push_back(std::make_shared<spdlog::sinks::stdout_sink_mt>());
+                try {
+                    file_ = std::make_shared<spdlog::sinks::rotating_file_sink_mt>("app_logs.txt", ROTATE_SIZE, ROTATE_FILES);
+                    sinks_.push_back(file_);
+                } catch (const spdlog::spdlog_ex& e) {
+                    // Keep logging to the console and the GUI, as when the file could not be opened before
+                    std::cerr << "Cannot open app_logs.txt, logging without it: " << e.what() << std::endl;
+                }
+                sinks_.push_back(std::make_shared<GuiSink>(buffer()));
+                for (auto& sink : sinks_) {
+                    sink->set_pattern("%v"); // Timestamp, level and source are part of the message
+                }
+                sinks_.push_back(std::make_shared<CompletionSink>());
+                flusher_ = std::make_unique<spdlog::details::periodic_worker>([this] {
+                    if (file_) file_->flush();
+                    reportDropped();
+                }, std::chrono::seconds(1));
+            }
+
+            ~SpdlogWriter() {
+                flusher_.reset();
+                reportDropped();
+                flush();
+                writerGone.store(true);
+            }
+
+            void log(Log::Level level, const std::string& source, const std::string& line) {
+                posted_.fetch_add(1, std::memory_order_relaxed);
+                logger(source).log(toSpdlog(level), spdlog::string_view_t(line));
+            }
+
+            // Loggers are created with the policy, so the next line of every source gets a new one
+            void setOverflowPolicy() {
+                std::lock_guard<std::mutex> guard(mutex_);
+                loggers_.clear();
+                generation_.fetch_add(1, std::memory_order_release);
+            }
+
+            // Wait until the lines posted before the call went through the sinks, at most FLUSH_TIMEOUT
+            void flush() {
+                std::uint64_t target = posted_.load(std::memory_order_relaxed);
+                auto deadline = std::chrono::steady_clock::now() + FLUSH_TIMEOUT;
+                while (written.load(std::memory_order_acquire) + pool_->overrun_counter() < target &&
+                       std::chrono::steady_clock::now() < deadline) {
+                    std::this_thread::yield();
+                }
+                if (file_) file_->flush();
+            }
+
+            std::uint64_t dropped() const { return pool_->overrun_counter(); }
+
+        private:
+            // spdlog drops lines without a trace, log how many went since the last call as the writer
+            // thread does. Called from one thread at a time
+            void reportDropped() {
+                std::uint64_t overrun = pool_->overrun_counter();
+                std::uint64_t lost = overrun - reported_;
+                reported_ = overrun;
+                if (lost && overflowPolicy.load(std::memory_order_relaxed) == Log::OverflowPolicy::CountAndDrop) {
+                    log(Log::Level::Warning, "Log", std::format("[WARN] [Log] {} log messages dropped", lost));
+                }
+            }
+
+            // Each thread caches the loggers it used, so the registry lock is only taken for a new source
+            spdlog::async_logger& logger(const std::string& source) {
+                thread_local std::unordered_map<std::string, std::shared_ptr<spdlog::async_logger>> cache;
+                thread_local std::uint64_t cacheGeneration = 0;
+                std::uint64_t generation = generation_.load(std::memory_order_acquire);
+                if (cacheGeneration != generation) {
+                    cache.clear();
+                    cacheGeneration = generation;
+                }
+                auto it = cache.find(source);
+                if (it != cache.end()) return *it->second;
+
+                std::lock_guard<std::mutex> guard(mutex_);
+                auto& logger = loggers_[source];
+                if (!logger) {
+                    auto policy = overflowPolicy.load(std::memory_order_relaxed) == Log::OverflowPolicy::Block
+                                  ? spdlog::async_overflow_policy::block
+                                  : spdlog::async_overflow_policy::overrun_oldest;
+                    logger = std::make_shared<spdlog::async_logger>(source, sinks_.begin(), sinks_.end(), pool_, policy);
+                    logger->set_level(spdlog::level::trace); // Filtered by Log::enabled already
+                    logger->flush_on(spdlog::level::warn);
+                }
+                return *cache.emplace(source, logger).first->second;
+            }
+
+            std::shared_ptr<spdlog::details::thread_pool> pool_;
+            std::shared_ptr<spdlog::sinks::rotating_file_sink_mt> file_; // Null when app_logs.txt cannot be opened
+            std::vector<spdlog::sink_ptr> sinks_;
+            std::unique_ptr<spdlog::details::periodic_worker> flusher_; // Flushes the file and reports drops every second
+            std::unordered_map<std::string, std::shared_ptr<spdlog::async_logger>> loggers_;
+            std::atomic<std::uint64_t> generation_{0};
+            std::atomic<std::uint64_t> posted_{0};
+            std::uint64_t reported_ = 0; // overrun_counter() at the last report
+            std::mutex mutex_;
+        };
+
+        SpdlogWriter& writer() {
+            static SpdlogWriter instance;
+            return instance;
+        }
+#else
+        constexpr std::size_t MAX_BATCH = 256; // Lines per write
+
+        // Owns the queue and the thread writing it to the console, app_logs.txt and the GUI buffer
+        class Writer {
+        public:
+            Writer() : queue_(QUEUE_CAPACITY), file_(std::fopen("app_logs.txt", "a")), buffer_(buffer()),
+                       thread_([this] { run(); }) {}
+
+            ~Writer() {
+                stopping_.store(true);
+                wake();
+                thread_.join();
+                if (file_) std::fclose(file_);
+                writerGone.store(true);
+            }
+
+            // False when the queue is full, record is left untouched then
+            bool push(Record& record) {
+                if (!queue_.tryPush(record)) return false;
+                pushed_.fetch_add(1, std::memory_order_release);
+                if (sleeping_.load(std::memory_order_seq_cst)) wake();
+                return true;
+            }
+
+            // Wait until everything pushed before the call is written
+            void flush() {
+                std::uint64_t target = pushed_.load(std::memory_order_acquire);
+                wake();
+                while (done_.load(std::memory_order_acquire) < target && !stopping_.load()) {
+                    std::this_thread::yield();
+                }
+            }
+
+        private:
+            void wake() {
+                signal_.fetch_add(1, std::memory_order_seq_cst);
+                signal_.notify_one();
+            }
+
+            void run() {
+                std::string batch;
+                std::vector<Record> lines;
+                while (true) {
+                    std::uint32_t seen = signal_.load(std::memory_order_seq_cst);
+                    std::uint64_t taken = drain(batch, lines);
+                    if (lines.empty()) {
+                        if (stopping_.load()) break;
+                        // Producers only notify while sleeping_ is set, re-check the queue after setting it
+                        sleeping_.store(true, std::memory_order_seq_cst);
+                        taken = drain(batch, lines);
+                        if (lines.empty()) signal_.wait(seen);
+                        sleeping_.store(false, std::memory_order_relaxed);
+                        if (lines.empty()) continue;
+                    }
+                    write(batch, lines);
+                    done_.fetch_add(taken, std::memory_order_release);
+                }
+            }
+
+            // Take up to MAX_BATCH lines off the queue, newline-terminated into batch, and add the
+            // report of dropped lines. Returns the number taken off the queue
+            std::uint64_t drain(std::string& batch, std::vector<Record>& lines) {
+                Record record;
+                std::uint64_t taken = 0;
+                while (taken < MAX_BATCH && queue_.tryPop(record)) {
+                    batch += record.text;
+                    batch += '\n';
+                    lines.push_back(std::move(record));
+                    ++taken;
+                }
+                std::uint64_t lost = unreported.exchange(0, std::memory_order_relaxed);
+                if (lost) {
+                    record.level = Log::Level::Warning;
+                    record.source = "Log";
+                    record.text = std::format("[WARN] [Log] {} log messages dropped", lost);
+                    batch += record.text;
+                    batch += '\n';
+                    lines.push_back(std::move(record));
+                }
+                return taken;
+            }
+
+            void write(std::string& batch, std::vector<Record>& lines) {
+                std::cout.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+                std::cout.flush();
+                if (file_) {
+                    std::fwrite(batch.data(), 1, batch.size(), file_);
+                    std::fflush(file_);
+                }
+                written.fetch_add(lines.size(), std::memory_order_relaxed);
+                buffer_.append(lines);
+                batch.clear();
+                lines.clear();
+            }
+
+            MpscRing<Record> queue_;
+            std::FILE* file_;
+            LogBuffer& buffer_; // Constructed first, so it outlives the writer
+            std::atomic<std::uint64_t> pushed_{0}; // Lines put on the queue
+            std::atomic<std::uint64_t> done_{0}; // Lines taken off the queue and written
+            std::atomic<std::uint32_t> signal_{0};
+            std::atomic<bool> sleeping_{false};
+            std::atomic<bool> stopping_{false};
+            std::thread thread_;
+        };
+
+        Writer& writer() {
+            static Writer instance;
+            return instance;
+        }
+#endif
+
+    } // namespace
 
     void Log::log(Level level, const std::string& message, const std::string& file) {
+        if (!enabled(level)) return;
+
         std::string prefix;
         switch (level) {
+            case Level::Debug: prefix = "[DEBUG]"; break;
             case Level::Info: prefix = "[INFO]"; break;
             case Level::Warning: prefix = "[WARN]"; break;
             case Level::Error: prefix = "[ERROR]"; break;
         }
 
-        std::string result = std::format("[{}] {} {}", getTimestamp(), prefix, message);
-        if (!file.empty()) result = std::format("[{}] {} [{}] {}", getTimestamp(), prefix, file, message);
+        // The timestamp is formatted once per second for all threads
+        auto now = System::Clock::now();
+        std::string text = file.empty() ? std::format("[{}] {} {}", now->timestamp, prefix, message)
+                                        : std::format("[{}] {} [{}] {}", now->timestamp, prefix, file, message);
+        if (writerGone.load(std::memory_order_relaxed)) {
+            // Static destruction already stopped the writer
+            std::cout << text << std::endl;
+            return;
+        }
 
-        {
-            std::lock_guard<std::mutex> guard(mutex_);
-            logs.push_back(result);
-            std::cout << result << std::endl;
-            writeToFile(result);
+#if ENABLE_LOGGING
+        writer().log(level, file, text);
+#else
+        Record record;
+        record.level = level;
+        record.source = file;
+        record.text = std::move(text);
+
+        Writer& out = writer();
+        if (out.push(record)) return;
+        switch (overflowPolicy.load(std::memory_order_relaxed)) {
+            case OverflowPolicy::Block:
+                while (!out.push(record)) std::this_thread::yield();
+                return;
+            case OverflowPolicy::CountAndDrop:
+                unreported.fetch_add(1, std::memory_order_relaxed);
+                [[fallthrough]];
+            case OverflowPolicy::Drop:
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
         }
+#endif
+    }
+
+    void Log::setOverflowPolicy(OverflowPolicy policy) {
+        overflowPolicy.store(policy, std::memory_order_relaxed);
+#if ENABLE_LOGGING
+        if (!writerGone.load(std::memory_order_relaxed)) writer().setOverflowPolicy();
+#endif
+    }
+
+    Log::OverflowPolicy Log::getOverflowPolicy() {
+        return overflowPolicy.load(std::memory_order_relaxed);
+    }
+
+    void Log::flush() {
+        if (!writerGone.load(std::memory_order_relaxed)) writer().flush();
+    }
+
+    const LogBuffer& Log::getBuffer() {
+        return buffer();
     }
 
-    void Log::writeToFile(const std::string& message) {
-        std::ofstream logFile("app_logs.txt", std::ios::app);
-        if (logFile.is_open()) {
-            logFile << message << std::endl;
+    Log::Stats Log::getStats() {
+#if ENABLE_LOGGING
+        if (!writerGone.load(std::memory_order_relaxed)) {
+            return {written.load(std::memory_order_relaxed), writer().dropped()};
         }
+#endif
+        return {written.load(std::memory_order_relaxed), dropped.load(std::memory_order_relaxed)};
     }
 
 } // namespace Debug
\ No newline at end of file
@@ -4,18 +4,69 @@
 #include <string>
 #include <vector>
 #include <mutex>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <format>
+#include <utility>
+
+// Lowest level compiled in, lines below it are removed by the LOG_* macros: 0 Debug, 1 Info,
+// 2 Warning, 3 Error. Production builds drop the per-request Debug lines
+#ifndef LOG_MIN_LEVEL
+#if PRODUCTION_BUILD
+#define LOG_MIN_LEVEL 1
+#else
+#define LOG_MIN_LEVEL 0
+#endif
+#endif
 
 namespace Debug {
 
+    class LogBuffer;
+
+    // Lines are formatted on the calling thread and queued for a background thread, which keeps
+    // app_logs.txt open and writes everything queued at once
     class Log {
     public:
-        enum class Level { Info, Warning, Error };
+        enum class Level { Debug, Info, Warning, Error };
+
+        // What happens to a line when the queue to the writer is full
+        enum class OverflowPolicy {
+            Block,       // Wait until the writer made room
+            Drop,        // Discard the line
+            CountAndDrop // Discard the line and report the number lost in the log (with spdlog the
+                         // oldest queued line goes instead, reported within a second)
+        };
+
+        struct Stats {
+            std::uint64_t written = 0; // Lines written by the writer thread
+            std::uint64_t dropped = 0; // Lines lost to a full queue
+        };
 
         // Log a message with specified level
         static void log(Level level, const std::string& message, const std::string& file = "");
 
+        // Whether lines of a level are logged: compiled in and at or above the runtime level
+        static bool enabled(Level level) {
+            return static_cast<int>(level) >= LOG_MIN_LEVEL &&
+                   level >= minLevel_.load(std::memory_order_relaxed);
+        }
+
+        // Lowest level logged at runtime, Debug by default (Info with PRODUCTION_BUILD)
+        static void setLevel(Level level) { minLevel_.store(level, std::memory_order_relaxed); }
+        static Level getLevel() { return minLevel_.load(std::memory_order_relaxed); }
+
+        // Format and log only when the level is enabled. The arguments are still evaluated, the
+        // LOG_* macros skip that as well
+        template <typename... Args>
+        static void logf(Level level, const std::string& file, std::format_string<Args...> format, Args&&... args) {
+            if (enabled(level)) log(level, std::format(format, std::forward<Args>(args)...), file);
+        }
+
         // Convenience methods
+        static void debug(const std::string& message, const std::string& file = "") {
+            log(Level::Debug, message, file);
+        }
         static void info(const std::string& message, const std::string& file = "") {
             log(Level::Info, message, file);
         }
@@ -26,14 +77,33 @@ namespace Debug {
             log(Level::Error, message, file);
         }
 
-        static std::vector<std::string> logs;
+        // Default CountAndDrop, request threads never wait for the disk
+        static void setOverflowPolicy(OverflowPolicy policy);
+        static OverflowPolicy getOverflowPolicy();
+
+        // Wait until every line logged so far is written
+        static void flush();
+
+        static Stats getStats();
+
+        // Recent lines shown in the GUI, appended by the writer thread
+        static const LogBuffer& getBuffer();
 
     private:
-        static std::string getTimestamp();
-        static void writeToFile(const std::string& message);
-        static std::mutex mutex_;
+        static inline std::atomic<Level> minLevel_{LOG_MIN_LEVEL > 0 ? static_cast<Level>(LOG_MIN_LEVEL) : Level::Debug};
     };
 
 } // namespace Debug
 
+// Log a formatted line, the format arguments are only evaluated when the level is enabled:
+// LOG_DEBUG("RequestHandler", "Served {}", path);
+#define LOG_AT(level, file, ...) \
+    do { \
+        if (::Debug::Log::enabled(level)) ::Debug::Log::log(level, std::format(__VA_ARGS__), file); \
+    } while (0)
+#define LOG_DEBUG(file, ...) LOG_AT(::Debug::Log::Level::Debug, file, __VA_ARGS__)
+#define LOG_INFO(file, ...) LOG_AT(::Debug::Log::Level::Info, file, __VA_ARGS__)
+#define LOG_WARN(file, ...) LOG_AT(::Debug::Log::Level::Warning, file, __VA_ARGS__)
+#define LOG_ERROR(file, ...) LOG_AT(::Debug::Log::Level::Error, file, __VA_ARGS__)
+
 #endif // LOG_H
\ No newline at end of file
@@ -0,0 +1,30 @@
+#include "LogBuffer.h"
+#include <algorithm>
+
+namespace Debug {
+
+    LogBuffer::LogBuffer(std::size_t capacity) : records_(std::max<std::size_t>(capacity, 1)) {}
+
+    void LogBuffer::append(std::vector<Record>& records) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        std::uint64_t next = next_.load(std::memory_order_relaxed);
+        for (auto& record : records) {
+            record.sequence = next;
+            records_[next % records_.size()] = std::move(record);
+            ++next;
+        }
+        next_.store(next, std::memory_order_release);
+    }
+
+    std::uint64_t LogBuffer::copySince(std::uint64_t since, std::vector<Record>& out) const {
+        if (since >= getSequence()) return since;
+        std::lock_guard<std::mutex> guard(mutex_);
+        std::uint64_t next = next_.load(std::memory_order_relaxed);
+        std::uint64_t oldest = next > records_.size() ? next - records_.size() : 0;
+        for (std::uint64_t sequence = std::max(since, oldest); sequence < next; ++sequence) {
+            out.push_back(records_[sequence % records_.size()]);
+        }
+        return next;
+    }
+
+} // namespace Debug
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef LOGBUFFER_H
+#define LOGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Log.h"
+
+namespace Debug {
+
+    // The most recent log lines for the GUI. Once full, every new line replaces the oldest one.
+    // Readers copy what was added since their last call, so the lock is only held for new lines
+    class LogBuffer {
+    public:
+        struct Record {
+            std::uint64_t sequence = 0; // Number of lines logged before this one
+            Log::Level level = Log::Level::Info;
+            std::string source; // The file argument of Log::log, may be empty
+            std::string text; // Formatted line
+        };
+
+        explicit LogBuffer(std::size_t capacity);
+
+        LogBuffer(const LogBuffer&) = delete;
+        LogBuffer& operator=(const LogBuffer&) = delete;
+
+        // Add records in order, assigning their sequence numbers
+        void append(std::vector<Record>& records);
+
+        // Sequence number the next line will get, cheap enough to poll every frame
+        std::uint64_t getSequence() const { return next_.load(std::memory_order_acquire); }
+
+        // Append copies of the records with a sequence of at least since to out and return the
+        // sequence to pass next time. Lines already replaced are skipped
+        std::uint64_t copySince(std::uint64_t since, std::vector<Record>& out) const;
+
+        std::size_t capacity() const { return records_.size(); }
+
+    private:
+        mutable std::mutex mutex_;
+        std::vector<Record> records_; // Record n lives at n % capacity
+        std::atomic<std::uint64_t> next_{0};
+    };
+
+} // namespace Debug
+
+#endif // LOGBUFFER_H
\ No newline at end of file
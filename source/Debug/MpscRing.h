@@ -0,0 +1,81 @@
+#ifndef MPSCRING_H
+#define MPSCRING_H
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace Debug {
+
+    // Bounded lock-free queue for many producers and a single consumer. Every cell carries a
+    // sequence number telling whose turn it is, so producers only contend on the enqueue
+    // position and never wait for each other (D. Vyukov's bounded queue).
+    template <typename T>
+    class MpscRing {
+    public:
+        // capacity is rounded up to a power of two
+        explicit MpscRing(std::size_t capacity)
+                : mask_(std::bit_ceil(capacity < 2 ? std::size_t(2) : capacity) - 1), cells_(new Cell[mask_ + 1]) {
+            for (std::size_t i = 0; i <= mask_; ++i) {
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        MpscRing(const MpscRing&) = delete;
+        MpscRing& operator=(const MpscRing&) = delete;
+
+        // Any thread. False when the ring is full, value is left untouched then
+        bool tryPush(T& value) {
+            std::size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+            Cell* cell;
+            while (true) {
+                cell = &cells_[pos & mask_];
+                std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+                if (diff == 0) {
+                    if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    return false; // The consumer has not taken the value a lap ago yet
+                } else {
+                    pos = enqueuePos_.load(std::memory_order_relaxed);
+                }
+            }
+            cell->value = std::move(value);
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer thread only. False when empty or the next producer has not finished writing
+        bool tryPop(T& value) {
+            Cell& cell = cells_[dequeuePos_ & mask_];
+            if (cell.sequence.load(std::memory_order_acquire) != dequeuePos_ + 1) {
+                return false;
+            }
+            value = std::move(cell.value);
+            cell.sequence.store(dequeuePos_ + mask_ + 1, std::memory_order_release);
+            ++dequeuePos_;
+            return true;
+        }
+
+        std::size_t capacity() const { return mask_ + 1; }
+
+    private:
+        struct Cell {
+            std::atomic<std::size_t> sequence;
+            T value;
+        };
+
+        std::size_t mask_;
+        std::unique_ptr<Cell[]> cells_;
+        alignas(64) std::atomic<std::size_t> enqueuePos_ = 0;
+        alignas(64) std::size_t dequeuePos_ = 0;
+    };
+
+} // namespace Debug
+
+#endif // MPSCRING_H
\ No newline at end of file
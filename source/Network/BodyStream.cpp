@@ -0,0 +1,113 @@
+#include "BodyStream.h"
+#include <boost/asio/error.hpp>
+#include <utility>
+
+namespace Network {
+
+    QueueBodyStream::QueueBodyStream(std::size_t highWater) : highWater_(highWater) {
+    }
+
+    bool QueueBodyStream::push(std::string_view data, const std::function<void()>& resume) {
+        if (data.empty()) {
+            return true;
+        }
+        ReadHandler handler;
+        std::function<void()> resumed;
+        boost::system::error_code error;
+        bool below = true;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (closed_) {
+                return true;
+            }
+            pending_.append(data);
+            handler = takeLocked(error, resumed);
+            if (pending_.size() >= highWater_) {
+                below = false;
+                resume_ = resume;
+            }
+        }
+        if (resumed) {
+            resumed();
+        }
+        if (handler) {
+            handler(error, reading_);
+        }
+        return below;
+    }
+
+    void QueueBodyStream::close(const boost::system::error_code& error) {
+        ReadHandler handler;
+        std::function<void()> resume;
+        boost::system::error_code result;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (closed_) {
+                return;
+            }
+            closed_ = true;
+            end_ = error ? error : boost::asio::error::eof;
+            handler = takeLocked(result, resume);
+            resume_ = nullptr; // Nothing more is pushed
+        }
+        if (handler) {
+            handler(result, reading_);
+        }
+    }
+
+    void QueueBodyStream::read(ReadHandler handler) {
+        std::function<void()> resume;
+        boost::system::error_code error;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            waiting_ = std::move(handler);
+            handler = takeLocked(error, resume);
+        }
+        if (resume) {
+            resume();
+        }
+        if (handler) {
+            handler(error, reading_);
+        }
+    }
+
+    BodyStream::ReadHandler QueueBodyStream::takeLocked(boost::system::error_code& error, std::function<void()>& resume) {
+        if (!waiting_ || (pending_.empty() && !closed_)) {
+            return {};
+        }
+        // The reader is done with reading_ once it waits again, so the buffers can be swapped
+        reading_.clear();
+        reading_.swap(pending_);
+        resume = std::exchange(resume_, nullptr);
+        error = closed_ ? end_ : boost::system::error_code();
+        return std::exchange(waiting_, nullptr);
+    }
+
+    CompressedBodyStream::CompressedBodyStream(std::shared_ptr<BodyStream> source, std::unique_ptr<Compressor::Encoder> encoder,
+                                               std::shared_ptr<Compressor> compressor)
+            : source_(std::move(source)), encoder_(std::move(encoder)), compressor_(std::move(compressor)) {
+    }
+
+    void CompressedBodyStream::read(ReadHandler handler) {
+        source_->read([self = shared_from_this(), handler = std::move(handler)](const boost::system::error_code& error,
+                                                                               std::string_view data) {
+            bool last = error == boost::asio::error::eof;
+            if (error && !last) {
+                handler(error, {});
+                return;
+            }
+            // data stays valid, the source is not read again before the piece is compressed
+            self->compressor_->post([self, handler, error, data, last]() {
+                self->output_.clear();
+                if (!self->encoder_->write(data, last, self->output_)) {
+                    handler(boost::system::errc::make_error_code(boost::system::errc::io_error), {});
+                } else if (self->output_.empty() && !last) {
+                    self->read(handler);
+                } else {
+                    handler(error, self->output_);
+                }
+            });
+        });
+    }
+
+} // namespace Network
\ No newline at end of file
@@ -0,0 +1,80 @@
+#ifndef BODYSTREAM_H
+#define BODYSTREAM_H
+
+#include <boost/system/error_code.hpp>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include "Compressor.h"
+
+namespace Network {
+
+// Response body produced while it is being sent, e.g. the output of a script. The connection
+// asks for the next piece only after the previous one was written, so a slow client holds
+// the producer back.
+class BodyStream {
+public:
+    // error is eof after the last piece, which may still carry data. The data stays valid until
+    // read() is called again or the stream is destroyed
+    using ReadHandler = std::function<void(const boost::system::error_code& error, std::string_view data)>;
+
+    virtual ~BodyStream() = default;
+
+    // Hand the next non-empty piece (or the end) to handler, which may run on any thread
+    virtual void read(ReadHandler handler) = 0;
+};
+
+// Stream fed by a producer pushing FastCGI records, buffering what the client has not taken yet.
+// Past highWater buffered bytes the producer is told to pause, and resumed once the reader
+// took the buffer. Thread-safe.
+class QueueBodyStream : public BodyStream {
+public:
+    static constexpr std::size_t defaultHighWater = 256 * 1024;
+
+    explicit QueueBodyStream(std::size_t highWater = defaultHighWater);
+
+    // Append output, false once highWater bytes wait for the reader. The producer should then
+    // stop until resume runs (once, on the reader's thread); a producer that cannot pause
+    // passes no resume and gives up instead
+    bool push(std::string_view data, const std::function<void()>& resume = {});
+
+    // End the body, an error other than eof aborts the response
+    void close(const boost::system::error_code& error);
+
+    void read(ReadHandler handler) override;
+
+private:
+    // Give pending data or the end to the waiting reader along with a paused producer's resume,
+    // caller holds mutex_ and calls what is returned
+    ReadHandler takeLocked(boost::system::error_code& error, std::function<void()>& resume);
+
+    std::size_t highWater_;
+    std::mutex mutex_;
+    std::string pending_;  // Pushed but not read yet
+    std::string reading_;  // Handed to the reader, kept alive until the next read
+    boost::system::error_code end_;
+    bool closed_ = false;
+    ReadHandler waiting_;
+    std::function<void()> resume_; // Producer paused at highWater_
+};
+
+// Compresses another stream piece by piece on the compression threads
+class CompressedBodyStream : public BodyStream, public std::enable_shared_from_this<CompressedBodyStream> {
+public:
+    CompressedBodyStream(std::shared_ptr<BodyStream> source, std::unique_ptr<Compressor::Encoder> encoder,
+                         std::shared_ptr<Compressor> compressor);
+
+    void read(ReadHandler handler) override;
+
+private:
+    std::shared_ptr<BodyStream> source_;
+    std::unique_ptr<Compressor::Encoder> encoder_;
+    std::shared_ptr<Compressor> compressor_;
+    std::string output_; // Compressed piece handed to the reader
+};
+
+} // namespace Network
+
+#endif // BODYSTREAM_H
\ No newline at end of file
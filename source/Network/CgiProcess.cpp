@@ -0,0 +1,181 @@
+#include "CgiProcess.h"
+#include "../Debug/Log.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+namespace Network {
+
+    namespace {
+        constexpr std::size_t readSize = 16 * 1024;
+
+#ifndef _WIN32
+        constexpr auto reapInterval = std::chrono::milliseconds(50);
+        constexpr int killAfter = 100; // Reap attempts (5 s) before a child still running is killed
+
+        // Collect an exited child without blocking the I/O thread, killing it if it does not exit
+        void reap(const std::shared_ptr<boost::asio::steady_timer>& timer, int pid, int attempts) {
+            if (::waitpid(pid, nullptr, WNOHANG) != 0) {
+                return;
+            }
+            if (attempts == killAfter) {
+                Debug::Log::error(std::format("CGI process {} did not exit, killing it", pid), "CgiProcess");
+                ::kill(pid, SIGKILL);
+            }
+            timer->expires_after(reapInterval);
+            timer->async_wait([timer, pid, attempts](const boost::system::error_code& error) {
+                if (!error) {
+                    reap(timer, pid, attempts + 1);
+                }
+            });
+        }
+#endif
+    }
+
+    bool CgiProcess::isSupported() {
+#if defined(BOOST_ASIO_HAS_POSIX_STREAM_DESCRIPTOR) && !defined(_WIN32)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+#if defined(BOOST_ASIO_HAS_POSIX_STREAM_DESCRIPTOR) && !defined(_WIN32)
+    std::shared_ptr<CgiProcess> CgiProcess::start(const boost::asio::any_io_executor& executor,
+                                                  const std::vector<std::string>& arguments,
+                                                  const std::vector<std::string>& environment, std::string input) {
+        // A script exiting before it read the whole body must not take the server down with SIGPIPE
+        static std::once_flag ignoreSigpipe;
+        std::call_once(ignoreSigpipe, []() { std::signal(SIGPIPE, SIG_IGN); });
+
+        int outputPipe[2];
+        if (::pipe2(outputPipe, O_CLOEXEC) != 0) {
+            Debug::Log::error(std::format("Cannot create CGI pipe: {}", std::strerror(errno)), "CgiProcess");
+            return nullptr;
+        }
+        int inputPipe[2] = {-1, -1};
+        if (!input.empty() && ::pipe2(inputPipe, O_CLOEXEC) != 0) {
+            Debug::Log::error(std::format("Cannot create CGI pipe: {}", std::strerror(errno)), "CgiProcess");
+            ::close(outputPipe[0]);
+            ::close(outputPipe[1]);
+            return nullptr;
+        }
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        if (inputPipe[0] >= 0) {
+            posix_spawn_file_actions_adddup2(&actions, inputPipe[0], STDIN_FILENO);
+        } else {
+            posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+        }
+        posix_spawn_file_actions_adddup2(&actions, outputPipe[1], STDOUT_FILENO);
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 34))
+        // Client sockets and other descriptors must not leak into the script
+        posix_spawn_file_actions_addclosefrom_np(&actions, STDERR_FILENO + 1);
+#endif
+        // The server ignores SIGPIPE, the script should die when the client is gone
+        posix_spawnattr_t attributes;
+        posix_spawnattr_init(&attributes);
+        sigset_t defaults;
+        sigemptyset(&defaults);
+        sigaddset(&defaults, SIGPIPE);
+        posix_spawnattr_setsigdefault(&attributes, &defaults);
+        posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSIGDEF);
+
+        std::vector<char*> argv, envp;
+        for (const auto& argument : arguments) {
+            argv.push_back(const_cast<char*>(argument.c_str()));
+        }
+        argv.push_back(nullptr);
+        for (const auto& variable : environment) {
+            envp.push_back(const_cast<char*>(variable.c_str()));
+        }
+        envp.push_back(nullptr);
+
+        // glibc spawns with CLONE_VFORK, the server's memory is not copied
+        pid_t pid = -1;
+        int result = ::posix_spawn(&pid, argv[0], &actions, &attributes, argv.data(), envp.data());
+        posix_spawn_file_actions_destroy(&actions);
+        posix_spawnattr_destroy(&attributes);
+        ::close(outputPipe[1]);
+        if (inputPipe[0] >= 0) {
+            ::close(inputPipe[0]);
+        }
+        if (result != 0) {
+            Debug::Log::error(std::format("Cannot start {}: {}", arguments.front(), std::strerror(result)), "CgiProcess");
+            ::close(outputPipe[0]);
+            if (inputPipe[1] >= 0) {
+                ::close(inputPipe[1]);
+            }
+            return nullptr;
+        }
+        auto process = std::make_shared<CgiProcess>(executor, pid, outputPipe[0], inputPipe[1]);
+        if (inputPipe[1] >= 0) {
+            process->writeInput(std::make_shared<const std::string>(std::move(input)));
+        }
+        return process;
+    }
+
+    CgiProcess::CgiProcess(const boost::asio::any_io_executor& executor, int pid, int outputFd, int inputFd)
+            : output_(executor, outputFd), input_(executor), executor_(executor), pid_(pid), buffer_(readSize) {
+        if (inputFd >= 0) {
+            input_.assign(inputFd);
+        }
+    }
+
+    CgiProcess::~CgiProcess() {
+        // A script still writing gets SIGPIPE once the read end is closed
+        boost::system::error_code ec;
+        output_.close(ec);
+        input_.close(ec);
+        reap(std::make_shared<boost::asio::steady_timer>(executor_), pid_, 0);
+    }
+
+    void CgiProcess::read(ReadHandler handler) {
+        output_.async_read_some(boost::asio::buffer(buffer_),
+                                [self = shared_from_this(), handler = std::move(handler)](const boost::system::error_code& error, std::size_t size) {
+            handler(error, std::string_view(self->buffer_.data(), size));
+        });
+    }
+
+    void CgiProcess::writeInput(std::shared_ptr<const std::string> input) {
+        boost::asio::async_write(input_, boost::asio::buffer(*input),
+                                 [weak = weak_from_this(), input](const boost::system::error_code&, std::size_t) {
+            // Also after EPIPE: a script that stopped reading does not need the rest
+            if (auto self = weak.lock()) {
+                boost::system::error_code ec;
+                self->input_.close(ec);
+            }
+        });
+    }
+#else
+    std::shared_ptr<CgiProcess> CgiProcess::start(const boost::asio::any_io_executor&, const std::vector<std::string>&,
+                                                  const std::vector<std::string>&, std::string) {
+        return nullptr;
+    }
+
+    CgiProcess::CgiProcess(const boost::asio::any_io_executor& executor, int pid, int, int)
+            : executor_(executor), pid_(pid) {
+    }
+
+    CgiProcess::~CgiProcess() = default;
+
+    void CgiProcess::read(ReadHandler handler) {
+        handler(boost::asio::error::operation_not_supported, {});
+    }
+
+    void CgiProcess::writeInput(std::shared_ptr<const std::string>) {
+    }
+#endif
+
+} // namespace Network
\ No newline at end of file
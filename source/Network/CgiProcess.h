@@ -0,0 +1,49 @@
+#ifndef CGIPROCESS_H
+#define CGIPROCESS_H
+
+#include <boost/asio.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+#include "BodyStream.h"
+
+namespace Network {
+
+// A CGI script run as a child process whose stdout is read through a non-blocking pipe and
+// handed out as a body stream. Reading stops while the client is slow, so the pipe fills up
+// and the script blocks instead of the server buffering its output. The request body is
+// written to its stdin meanwhile. POSIX only.
+class CgiProcess : public BodyStream, public std::enable_shared_from_this<CgiProcess> {
+public:
+    // Start arguments[0] directly (no shell) with exactly the given NAME=value environment and
+    // input as stdin, null if the process cannot be created
+    static std::shared_ptr<CgiProcess> start(const boost::asio::any_io_executor& executor,
+                                             const std::vector<std::string>& arguments,
+                                             const std::vector<std::string>& environment, std::string input);
+
+    static bool isSupported();
+
+    // inputFd is -1 when the script gets no body
+    CgiProcess(const boost::asio::any_io_executor& executor, int pid, int outputFd, int inputFd);
+
+    // Close the pipe and collect the child in the background
+    ~CgiProcess() override;
+
+    void read(ReadHandler handler) override;
+
+private:
+    // Write the request body and close stdin, the script sees EOF after it
+    void writeInput(std::shared_ptr<const std::string> input);
+
+#if defined(BOOST_ASIO_HAS_POSIX_STREAM_DESCRIPTOR)
+    boost::asio::posix::stream_descriptor output_;
+    boost::asio::posix::stream_descriptor input_;
+#endif
+    boost::asio::any_io_executor executor_;
+    int pid_;
+    std::vector<char> buffer_;
+};
+
+} // namespace Network
+
+#endif // CGIPROCESS_H
\ No newline at end of file
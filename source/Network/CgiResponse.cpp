@@ -0,0 +1,187 @@
+#include "CgiResponse.h"
+#include <boost/asio/error.hpp>
+#include <algorithm>
+#include <charconv>
+
+namespace Network {
+
+    namespace {
+        // Size of the header block including the empty line, 0 while it is incomplete
+        std::size_t findBlockEnd(std::string_view data) {
+            std::size_t pos = 0;
+            while (true) {
+                std::size_t newline = data.find('\n', pos);
+                if (newline == std::string_view::npos) {
+                    return 0;
+                }
+                std::size_t length = newline - pos;
+                if (length == 0 || (length == 1 && data[pos] == '\r')) {
+                    return newline + 1;
+                }
+                pos = newline + 1;
+            }
+        }
+
+        std::string_view trim(std::string_view value) {
+            while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+            while (!value.empty() && (value.back() == ' ' || value.back() == '\t' || value.back() == '\r')) value.remove_suffix(1);
+            return value;
+        }
+
+        // Fields describing the script's connection to us, not the response
+        bool isHopByHop(std::string_view name) {
+            return equalsIgnoreCase(name, "Connection") || equalsIgnoreCase(name, "Keep-Alive")
+                   || equalsIgnoreCase(name, "Transfer-Encoding") || equalsIgnoreCase(name, "Content-Length");
+        }
+    }
+
+    CgiResponse::Result CgiResponse::parse(std::string_view data) {
+        if (buffer_.empty()) {
+            // Common case: the whole block is in the first piece and nothing is copied
+            if (std::size_t end = findBlockEnd(data)) {
+                body_ = data.substr(end);
+                return end > maxHeaderSize ? Result::Invalid : parseBlock(data.substr(0, end));
+            }
+        }
+        buffer_.append(data);
+        std::size_t end = findBlockEnd(buffer_);
+        if (end == 0) {
+            return buffer_.size() > maxHeaderSize ? Result::Invalid : Result::Incomplete;
+        }
+        body_ = std::string_view(buffer_).substr(end);
+        return end > maxHeaderSize ? Result::Invalid : parseBlock(std::string_view(buffer_).substr(0, end));
+    }
+
+    CgiResponse::Result CgiResponse::parseBlock(std::string_view block) {
+        status_ = contentType_ = location_ = {};
+        headers_.clear();
+        while (!block.empty()) {
+            std::size_t newline = block.find('\n');
+            std::string_view line = block.substr(0, newline);
+            block.remove_prefix(newline + 1);
+            if (trim(line).empty()) {
+                break;
+            }
+            std::size_t colon = line.find(':');
+            if (colon == std::string_view::npos || colon == 0) {
+                return Result::Invalid;
+            }
+            std::string_view name = line.substr(0, colon);
+            std::string_view value = trim(line.substr(colon + 1));
+            if (equalsIgnoreCase(name, "Status")) {
+                // "404 Not Found", the code alone is accepted too
+                int code = 0;
+                auto [last, error] = std::from_chars(value.data(), value.data() + std::min<std::size_t>(value.size(), 3), code);
+                if (error != std::errc() || last != value.data() + 3 || code < 100 || code > 599
+                    || (value.size() > 3 && value[3] != ' ')) {
+                    return Result::Invalid;
+                }
+                status_ = value;
+            } else if (equalsIgnoreCase(name, "Content-Type")) {
+                contentType_ = value;
+            } else if (equalsIgnoreCase(name, "Location")) {
+                location_ = value;
+            } else if (!isHopByHop(name) && !equalsIgnoreCase(name, "Date")) { // The server sends its own Date
+                headers_.push_back({name, value});
+            }
+        }
+        return Result::Complete;
+    }
+
+    void CgiResponse::apply(HttpResponse& response) const {
+        if (!status_.empty()) {
+            response.status = status_;
+            if (response.status.size() == 3) {
+                response.status += ' '; // The status line needs the separator even without a reason
+            }
+        } else if (!location_.empty()) {
+            response.status = "302 Found";
+        }
+        if (!contentType_.empty()) {
+            response.contentType = contentType_;
+        }
+        if (!location_.empty()) {
+            response.headers.emplace_back("Location", std::string(location_));
+        }
+        for (const auto& header : headers_) {
+            response.headers.emplace_back(std::string(header.name), std::string(header.value));
+            if (equalsIgnoreCase(header.name, "Cache-Control")) {
+                response.cacheTtl = cacheLifetime(header.value);
+            }
+        }
+    }
+
+    std::optional<std::chrono::seconds> CgiResponse::cacheLifetime(std::string_view cacheControl) {
+        std::optional<std::chrono::seconds> maxAge, sharedMaxAge;
+        while (!cacheControl.empty()) {
+            std::size_t comma = cacheControl.find(',');
+            std::string_view directive = trim(cacheControl.substr(0, comma));
+            cacheControl.remove_prefix(comma == std::string_view::npos ? cacheControl.size() : comma + 1);
+
+            std::size_t equals = directive.find('=');
+            std::string_view name = trim(directive.substr(0, equals));
+            if (equalsIgnoreCase(name, "no-store") || equalsIgnoreCase(name, "no-cache") || equalsIgnoreCase(name, "private")) {
+                return std::chrono::seconds(0);
+            }
+            if (equals == std::string_view::npos) {
+                continue;
+            }
+            std::string_view value = trim(directive.substr(equals + 1));
+            if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+                value = value.substr(1, value.size() - 2);
+            }
+            long long seconds = 0;
+            auto [last, error] = std::from_chars(value.data(), value.data() + value.size(), seconds);
+            if (error != std::errc() || last != value.data() + value.size() || seconds < 0) {
+                continue;
+            }
+            if (equalsIgnoreCase(name, "s-maxage")) {
+                sharedMaxAge = std::chrono::seconds(seconds);
+            } else if (equalsIgnoreCase(name, "max-age")) {
+                maxAge = std::chrono::seconds(seconds);
+            }
+        }
+        return sharedMaxAge ? sharedMaxAge : maxAge;
+    }
+
+    CgiBodyStream::CgiBodyStream(std::shared_ptr<BodyStream> source) : source_(std::move(source)) {
+    }
+
+    void CgiBodyStream::readHeaders(HeadersHandler handler) {
+        source_->read([self = shared_from_this(), handler = std::move(handler)](const boost::system::error_code& error,
+                                                                               std::string_view data) {
+            bool last = error == boost::asio::error::eof;
+            if (error && !last) {
+                handler(error, self->headers_);
+                return;
+            }
+            switch (self->headers_.parse(data)) {
+                case CgiResponse::Result::Complete:
+                    self->ended_ = last;
+                    self->pending_ = !self->headers_.body().empty() || last;
+                    handler({}, self->headers_);
+                    return;
+                case CgiResponse::Result::Invalid:
+                    handler(boost::system::errc::make_error_code(boost::system::errc::bad_message), self->headers_);
+                    return;
+                case CgiResponse::Result::Incomplete:
+                    if (last) {
+                        handler(boost::system::errc::make_error_code(boost::system::errc::bad_message), self->headers_);
+                    } else {
+                        self->readHeaders(handler);
+                    }
+                    return;
+            }
+        });
+    }
+
+    void CgiBodyStream::read(ReadHandler handler) {
+        if (pending_) {
+            pending_ = false;
+            handler(ended_ ? boost::asio::error::eof : boost::system::error_code(), headers_.body());
+            return;
+        }
+        source_->read(std::move(handler));
+    }
+
+} // namespace Network
\ No newline at end of file
@@ -0,0 +1,85 @@
+#ifndef CGIRESPONSE_H
+#define CGIRESPONSE_H
+
+#include <boost/system/error_code.hpp>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "BodyStream.h"
+#include "HttpParser.h"
+#include "HttpResponse.h"
+
+namespace Network {
+
+// Header block a CGI script writes before its body (RFC 3875 6.2): Status, Content-Type,
+// Location and any other fields, ended by an empty line. Lines may end with LF or CRLF.
+class CgiResponse {
+public:
+    enum class Result {
+        Complete,   // Header block parsed, body() holds the output following it
+        Incomplete, // Need more output
+        Invalid     // Malformed field, bad Status or block larger than maxHeaderSize
+    };
+
+    static constexpr std::size_t maxHeaderSize = 16 * 1024;
+
+    // Feed the next piece of output. When the first piece holds the whole block the fields are
+    // views into it, otherwise the pieces are joined in an internal buffer
+    Result parse(std::string_view data);
+
+    std::string_view status() const { return status_; }
+    std::string_view contentType() const { return contentType_; }
+    std::string_view location() const { return location_; }
+
+    // Every other field in order, without hop-by-hop fields and Content-Length
+    const std::vector<HttpHeader>& headers() const { return headers_; }
+
+    // Output after the header block in the piece that completed it
+    std::string_view body() const { return body_; }
+
+    // Merge into response: status (302 for a bare Location), Content-Type, the other fields, and
+    // the Cache-Control lifetime as cacheTtl
+    void apply(HttpResponse& response) const;
+
+    // How long a shared cache may keep a response with this Cache-Control value: s-maxage, else
+    // max-age, zero for no-store/no-cache/private, empty when it does not say
+    static std::optional<std::chrono::seconds> cacheLifetime(std::string_view cacheControl);
+
+private:
+    Result parseBlock(std::string_view block);
+
+    std::string buffer_; // Pieces received while the block is incomplete
+    std::string_view status_;
+    std::string_view contentType_;
+    std::string_view location_;
+    std::vector<HttpHeader> headers_;
+    std::string_view body_;
+};
+
+// Script output with the CGI header block taken off: readHeaders() first, then read() hands out
+// the body, starting with what followed the block in the same piece
+class CgiBodyStream : public BodyStream, public std::enable_shared_from_this<CgiBodyStream> {
+public:
+    // error is set when the output failed or ended before a valid block, headers are valid until the next read()
+    using HeadersHandler = std::function<void(const boost::system::error_code& error, const CgiResponse& headers)>;
+
+    explicit CgiBodyStream(std::shared_ptr<BodyStream> source);
+
+    void readHeaders(HeadersHandler handler);
+
+    void read(ReadHandler handler) override;
+
+private:
+    std::shared_ptr<BodyStream> source_;
+    CgiResponse headers_;
+    bool pending_ = false; // headers_.body() not handed out yet
+    bool ended_ = false;   // The source ended with the piece completing the block
+};
+
+} // namespace Network
+
+#endif // CGIRESPONSE_H
\ No newline at end of file
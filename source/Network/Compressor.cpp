@@ -0,0 +1,254 @@
+#include "Compressor.h"
+#include <boost/asio/post.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <zlib.h>
+
+#if ENABLE_BROTLI
+#include <brotli/encode.h>
+#endif
+#if ENABLE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace Network {
+
+    namespace {
+        std::size_t defaultThreadCount() {
+            return std::max<std::size_t>(1, std::thread::hardware_concurrency() / 2);
+        }
+
+        // gzip (windowBits 31) or zlib-wrapped deflate (windowBits 15)
+        std::optional<std::string> compressZlib(std::string_view data, int windowBits, int level) {
+            z_stream stream{};
+            if (deflateInit2(&stream, level, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                return std::nullopt;
+            }
+            std::string result(deflateBound(&stream, static_cast<uLong>(data.size())), '\0');
+            stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+            stream.avail_in = static_cast<uInt>(data.size());
+            stream.next_out = reinterpret_cast<Bytef*>(result.data());
+            stream.avail_out = static_cast<uInt>(result.size());
+            int status = deflate(&stream, Z_FINISH);
+            result.resize(stream.total_out);
+            deflateEnd(&stream);
+            if (status != Z_STREAM_END) {
+                return std::nullopt;
+            }
+            return result;
+        }
+
+        constexpr std::size_t encoderChunk = 16 * 1024;
+
+        class ZlibEncoder : public Compressor::Encoder {
+        public:
+            ~ZlibEncoder() override {
+                if (ready_) {
+                    deflateEnd(&stream_);
+                }
+            }
+
+            bool init(int windowBits, int level) {
+                ready_ = deflateInit2(&stream_, level, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+                return ready_;
+            }
+
+            bool write(std::string_view data, bool finish, std::string& out) override {
+                if (data.size() > std::numeric_limits<uInt>::max()) {
+                    return false;
+                }
+                stream_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+                stream_.avail_in = static_cast<uInt>(data.size());
+                int status;
+                do {
+                    std::size_t offset = out.size();
+                    out.resize(offset + encoderChunk);
+                    stream_.next_out = reinterpret_cast<Bytef*>(out.data() + offset);
+                    stream_.avail_out = static_cast<uInt>(encoderChunk);
+                    // Z_SYNC_FLUSH ends every piece on a byte boundary the client can decode up to
+                    status = deflate(&stream_, finish ? Z_FINISH : Z_SYNC_FLUSH);
+                    out.resize(out.size() - stream_.avail_out);
+                    if (status == Z_STREAM_ERROR) {
+                        return false;
+                    }
+                } while (finish ? status == Z_OK : stream_.avail_out == 0);
+                return !finish || status == Z_STREAM_END;
+            }
+
+        private:
+            z_stream stream_{};
+            bool ready_ = false;
+        };
+
+#if ENABLE_BROTLI
+        class BrotliEncoder : public Compressor::Encoder {
+        public:
+            explicit BrotliEncoder(int level) : state_(BrotliEncoderCreateInstance(nullptr, nullptr, nullptr)) {
+                if (state_) {
+                    BrotliEncoderSetParameter(state_, BROTLI_PARAM_QUALITY, static_cast<std::uint32_t>(level));
+                    BrotliEncoderSetParameter(state_, BROTLI_PARAM_MODE, BROTLI_MODE_TEXT);
+                }
+            }
+
+            ~BrotliEncoder() override {
+                if (state_) {
+                    BrotliEncoderDestroyInstance(state_);
+                }
+            }
+
+            bool ready() const { return state_ != nullptr; }
+
+            bool write(std::string_view data, bool finish, std::string& out) override {
+                std::size_t availableIn = data.size();
+                auto nextIn = reinterpret_cast<const std::uint8_t*>(data.data());
+                auto operation = finish ? BROTLI_OPERATION_FINISH : BROTLI_OPERATION_FLUSH;
+                do {
+                    std::size_t availableOut = 0;
+                    if (!BrotliEncoderCompressStream(state_, operation, &availableIn, &nextIn, &availableOut, nullptr, nullptr)) {
+                        return false;
+                    }
+                    while (BrotliEncoderHasMoreOutput(state_)) {
+                        std::size_t size = 0;
+                        const std::uint8_t* output = BrotliEncoderTakeOutput(state_, &size);
+                        out.append(reinterpret_cast<const char*>(output), size);
+                    }
+                } while (availableIn > 0 || (finish && !BrotliEncoderIsFinished(state_)));
+                return true;
+            }
+
+        private:
+            BrotliEncoderState* state_;
+        };
+#endif
+
+#if ENABLE_ZSTD
+        class ZstdEncoder : public Compressor::Encoder {
+        public:
+            explicit ZstdEncoder(int level) : context_(ZSTD_createCCtx()) {
+                if (context_) {
+                    ZSTD_CCtx_setParameter(context_, ZSTD_c_compressionLevel, level);
+                }
+            }
+
+            ~ZstdEncoder() override {
+                ZSTD_freeCCtx(context_);
+            }
+
+            bool ready() const { return context_ != nullptr; }
+
+            bool write(std::string_view data, bool finish, std::string& out) override {
+                ZSTD_inBuffer input{data.data(), data.size(), 0};
+                std::size_t remaining;
+                do {
+                    std::size_t offset = out.size();
+                    out.resize(offset + encoderChunk);
+                    ZSTD_outBuffer output{out.data() + offset, encoderChunk, 0};
+                    // Returns 0 once the input is consumed and everything flushed
+                    remaining = ZSTD_compressStream2(context_, &output, &input, finish ? ZSTD_e_end : ZSTD_e_flush);
+                    out.resize(offset + output.pos);
+                    if (ZSTD_isError(remaining)) {
+                        return false;
+                    }
+                } while (remaining != 0);
+                return true;
+            }
+
+        private:
+            ZSTD_CCtx* context_;
+        };
+#endif
+    }
+
+    Compressor::Compressor(std::size_t threadCount)
+            : pool_(threadCount ? threadCount : defaultThreadCount()) {
+    }
+
+    Compressor::~Compressor() {
+        pool_.join();
+    }
+
+    unsigned Compressor::available() {
+        unsigned codings = ContentEncoding::Gzip | ContentEncoding::Deflate;
+#if ENABLE_BROTLI
+        codings |= ContentEncoding::Brotli;
+#endif
+#if ENABLE_ZSTD
+        codings |= ContentEncoding::Zstd;
+#endif
+        return codings;
+    }
+
+    std::optional<std::string> Compressor::compress(std::string_view data, ContentEncoding::Coding coding, int level) {
+        level = std::clamp(level, 1, 9);
+        if (data.size() > std::numeric_limits<uInt>::max()) {
+            return std::nullopt;
+        }
+        switch (coding) {
+            case ContentEncoding::Gzip:
+                return compressZlib(data, 15 + 16, level);
+            case ContentEncoding::Deflate:
+                return compressZlib(data, 15, level);
+#if ENABLE_BROTLI
+            case ContentEncoding::Brotli: {
+                std::string result(BrotliEncoderMaxCompressedSize(data.size()), '\0');
+                std::size_t size = result.size();
+                if (result.empty() || !BrotliEncoderCompress(level, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT, data.size(),
+                                                             reinterpret_cast<const std::uint8_t*>(data.data()), &size,
+                                                             reinterpret_cast<std::uint8_t*>(result.data()))) {
+                    return std::nullopt;
+                }
+                result.resize(size);
+                return result;
+            }
+#endif
+#if ENABLE_ZSTD
+            case ContentEncoding::Zstd: {
+                std::string result(ZSTD_compressBound(data.size()), '\0');
+                std::size_t size = ZSTD_compress(result.data(), result.size(), data.data(), data.size(), level);
+                if (ZSTD_isError(size)) {
+                    return std::nullopt;
+                }
+                result.resize(size);
+                return result;
+            }
+#endif
+            default:
+                return std::nullopt;
+        }
+    }
+
+    std::unique_ptr<Compressor::Encoder> Compressor::encoder(ContentEncoding::Coding coding, int level) {
+        level = std::clamp(level, 1, 9);
+        switch (coding) {
+            case ContentEncoding::Gzip:
+            case ContentEncoding::Deflate: {
+                auto encoder = std::make_unique<ZlibEncoder>();
+                if (!encoder->init(coding == ContentEncoding::Gzip ? 15 + 16 : 15, level)) {
+                    return nullptr;
+                }
+                return encoder;
+            }
+#if ENABLE_BROTLI
+            case ContentEncoding::Brotli: {
+                auto encoder = std::make_unique<BrotliEncoder>(level);
+                return encoder->ready() ? std::move(encoder) : nullptr;
+            }
+#endif
+#if ENABLE_ZSTD
+            case ContentEncoding::Zstd: {
+                auto encoder = std::make_unique<ZstdEncoder>(level);
+                return encoder->ready() ? std::move(encoder) : nullptr;
+            }
+#endif
+            default:
+                return nullptr;
+        }
+    }
+
+    void Compressor::post(std::function<void()> work) {
+        boost::asio::post(pool_, std::move(work));
+    }
+
+} // namespace Network
\ No newline at end of file
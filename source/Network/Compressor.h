@@ -0,0 +1,51 @@
+#ifndef COMPRESSOR_H
+#define COMPRESSOR_H
+
+#include <boost/asio/thread_pool.hpp>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "ContentEncoding.h"
+
+namespace Network {
+
+// On-the-fly response compression: gzip and deflate through zlib, brotli and zstd when the
+// build found them (ENABLE_BROTLI, ENABLE_ZSTD). Work runs on a thread pool of its own so
+// connections never block an I/O thread while a body is compressed.
+class Compressor {
+public:
+    // Incremental encoder for a body compressed while it is produced (streamed script output)
+    class Encoder {
+    public:
+        virtual ~Encoder() = default;
+
+        // Append the compressed form of data to out, flushed so the client can decode everything
+        // so far; finish ends the compressed stream. False on failure
+        virtual bool write(std::string_view data, bool finish, std::string& out) = 0;
+    };
+
+    // threadCount 0 uses half the hardware threads, at least one
+    explicit Compressor(std::size_t threadCount = 0);
+    ~Compressor();
+
+    // Codings this build can produce, as a ContentEncoding set
+    static unsigned available();
+
+    // Compress data with a zlib-style level (1-9), empty if the coding is unavailable or fails
+    static std::optional<std::string> compress(std::string_view data, ContentEncoding::Coding coding, int level);
+
+    // Encoder for coding with a zlib-style level, null if the coding is unavailable
+    static std::unique_ptr<Encoder> encoder(ContentEncoding::Coding coding, int level);
+
+    // Run work on the compression threads
+    void post(std::function<void()> work);
+
+private:
+    boost::asio::thread_pool pool_;
+};
+
+} // namespace Network
+
+#endif // COMPRESSOR_H
\ No newline at end of file
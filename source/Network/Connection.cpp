@@ -0,0 +1,497 @@
+#include "Connection.h"
+#include "RequestHandler.h"
+#include "../Debug/Log.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef __linux__
+#include <cerrno>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#endif
+
+namespace Network {
+
+    Connection::Connection(std::shared_ptr<boost::asio::ip::tcp::socket> socket, std::shared_ptr<RequestHandler> handler,
+                           std::function<void()> onClose, std::function<void()> onRequest)
+            : socket_(std::move(socket)), handler_(std::move(handler)), onClose_(std::move(onClose)), onRequest_(std::move(onRequest)),
+              strand_(boost::asio::make_strand(socket_->get_executor())), idleTimer_(strand_), buffer_(initialBufferSize) {
+    }
+
+    Connection::~Connection() {
+        if (onClose_) {
+            onClose_();
+        }
+    }
+
+    void Connection::start() {
+        boost::system::error_code ec;
+        if (auto remote = socket_->remote_endpoint(ec); !ec) {
+            remoteAddress_ = remote.address().to_string();
+            remotePort_ = remote.port();
+        }
+        if (auto local = socket_->local_endpoint(ec); !ec) {
+            localAddress_ = local.address().to_string();
+            localPort_ = local.port();
+        }
+        boost::asio::dispatch(strand_, [self = shared_from_this()]() { self->doRead(); });
+    }
+
+    void Connection::doRead() {
+        switch (parser_.parse(std::string_view(buffer_.data(), buffered_), request_)) {
+            case HttpParser::Result::Complete:
+                headOnly_ = request_.method == "HEAD";
+                if (waitingForRequest_) {
+                    waitingForRequest_ = false;
+                    idleTimer_.cancel();
+                }
+                readBody();
+                return;
+            case HttpParser::Result::Invalid:
+                headOnly_ = false;
+                Debug::Log::error("Malformed request", "Connection");
+                respondError("400 Bad Request");
+                return;
+            case HttpParser::Result::HeadTooLarge:
+            case HttpParser::Result::TooManyHeaders:
+                headOnly_ = false;
+                Debug::Log::error("Request head too large", "Connection");
+                respondError("431 Request Header Fields Too Large");
+                return;
+            case HttpParser::Result::Incomplete:
+                break;
+        }
+
+        if (buffered_ == buffer_.size()) {
+            // Grow for large heads, the parser reports HeadTooLarge once the limit is passed
+            buffer_.resize(std::min(buffer_.size() * 2, parser_.limits().maxHeadSize + 1));
+        }
+        if (!waitingForRequest_) {
+            waitingForRequest_ = true;
+            armIdleTimer();
+        }
+        socket_->async_read_some(boost::asio::buffer(buffer_.data() + buffered_, buffer_.size() - buffered_),
+                                 boost::asio::bind_executor(strand_, [self = shared_from_this()](const boost::system::error_code& error, std::size_t bytesTransferred) {
+                                     self->onRead(error, bytesTransferred);
+                                 }));
+    }
+
+    void Connection::onRead(const boost::system::error_code& error, std::size_t bytesTransferred) {
+        if (error == boost::asio::error::eof || error == boost::asio::error::operation_aborted) {
+            idleTimer_.cancel();
+            return; // Client closed the connection or it went idle between requests
+        }
+        if (error) {
+            idleTimer_.cancel();
+            Debug::Log::error(std::format("Error reading request: {}", error.message()), "Connection");
+            return;
+        }
+        buffered_ += bytesTransferred;
+        doRead();
+    }
+
+    void Connection::readBody() {
+        std::size_t length = request_.contentLength;
+        std::size_t limit = handler_->getConfig()->limitRequestBody;
+        if (limit && length > limit) {
+            Debug::Log::error(std::format("Request body of {} bytes exceeds LimitRequestBody", length), "Connection");
+            respondError("413 Content Too Large");
+            return;
+        }
+
+        // What arrived with the head is copied, the rest is read straight into the body so the head views stay valid
+        bodyRead_ = std::min(length, buffered_ - parser_.headSize());
+        requestBody_.assign(buffer_.data() + parser_.headSize(), bodyRead_);
+        requestBody_.resize(length);
+        if (bodyRead_ < length && equalsIgnoreCase(request_.header("Expect"), "100-continue")) {
+            static constexpr std::string_view interim = "HTTP/1.1 100 Continue\r\n\r\n";
+            boost::asio::async_write(*socket_, boost::asio::buffer(interim.data(), interim.size()),
+                                     boost::asio::bind_executor(strand_, [self = shared_from_this()](const boost::system::error_code& error, std::size_t) {
+                                         if (error) {
+                                             Debug::Log::error(std::format("Error writing 100 Continue: {}", error.message()), "Connection");
+                                             return;
+                                         }
+                                         self->doReadBody();
+                                     }));
+            return;
+        }
+        doReadBody();
+    }
+
+    void Connection::doReadBody() {
+        if (bodyRead_ == requestBody_.size()) {
+            if (waitingForRequest_) {
+                waitingForRequest_ = false;
+                idleTimer_.cancel();
+            }
+            respond();
+            return;
+        }
+        // A client stalling mid-body is dropped like an idle one
+        waitingForRequest_ = true;
+        armIdleTimer();
+        socket_->async_read_some(boost::asio::buffer(requestBody_.data() + bodyRead_, requestBody_.size() - bodyRead_),
+                                 boost::asio::bind_executor(strand_, [self = shared_from_this()](const boost::system::error_code& error, std::size_t bytesTransferred) {
+                                     if (error) {
+                                         self->idleTimer_.cancel();
+                                         if (error != boost::asio::error::eof && error != boost::asio::error::operation_aborted) {
+                                             Debug::Log::error(std::format("Error reading request body: {}", error.message()), "Connection");
+                                         }
+                                         return;
+                                     }
+                                     self->bodyRead_ += bytesTransferred;
+                                     self->doReadBody();
+                                 }));
+    }
+
+    void Connection::respond() {
+        ++requestsServed_;
+        if (onRequest_) {
+            onRequest_();
+        }
+        auto config = handler_->getConfig();
+        request_.body = requestBody_;
+        request_.remoteAddress = remoteAddress_;
+        request_.remotePort = remotePort_;
+        request_.localAddress = localAddress_;
+        request_.localPort = localPort_;
+        HttpResponse response;
+        try {
+            response = handler_->processRequest(request_, requestsServed_ < config->maxKeepAliveRequests, strand_);
+        } catch (const std::exception& e) {
+            Debug::Log::error(std::format("Error handling request: {}", e.what()), "Connection");
+            response.keepAlive = false;
+            response.setError("500 Internal Server Error", "<h1>500 Internal Server Error</h1>");
+        }
+
+        // The request views are not needed any more, drop the head and the part of the body buffered with it
+        std::size_t consumed = parser_.headSize() + std::min(request_.contentLength, buffered_ - parser_.headSize());
+        request_.clear();
+        requestBody_ = std::string();
+        consume(consumed);
+        parser_.reset();
+        deliver(std::move(response));
+    }
+
+    void Connection::deliver(HttpResponse&& response) {
+        // Both steps complete on other threads, writing resumes on the strand
+        auto resume = [self = shared_from_this()](HttpResponse&& next) {
+            boost::asio::post(self->strand_, [self, next = std::move(next)]() mutable {
+                self->deliver(std::move(next));
+            });
+        };
+        if (response.deferred) {
+            auto deferred = std::move(response.deferred);
+            deferred(std::move(resume));
+            return;
+        }
+        if (response.finish) {
+            handler_->finishResponse(std::move(response), std::move(resume));
+            return;
+        }
+        setResponse(std::move(response));
+    }
+
+    void Connection::setResponse(HttpResponse&& response) {
+        keepAlive_ = response.keepAlive;
+        responseHead_ = response.serializeHead();
+        responseBody_ = std::move(response.body);
+        responseSharedBody_ = std::move(response.sharedBody);
+        responseFile_ = std::move(response.file);
+        responseParts_ = std::move(response.parts);
+        responseStream_ = std::move(response.stream);
+        responseChunked_ = response.chunked;
+        if (responseFile_ && responseParts_.empty()) {
+            responseParts_.push_back({std::string(), responseFile_->offset, responseFile_->length});
+        }
+        doWrite();
+    }
+
+    void Connection::respondError(const std::string& status) {
+        if (waitingForRequest_) {
+            waitingForRequest_ = false;
+            idleTimer_.cancel();
+        }
+        HttpResponse response;
+        response.setError(status, std::format("<h1>{}</h1>", status));
+        setResponse(std::move(response));
+    }
+
+    void Connection::doWrite() {
+        if (responseStream_) {
+            streamHeadSent_ = false;
+            readStream();
+            return;
+        }
+        if (headOnly_) {
+            // The head announces the body GET would get, which must not follow it
+            responseFile_.reset();
+            boost::asio::async_write(*socket_, boost::asio::buffer(responseHead_),
+                                     boost::asio::bind_executor(strand_, [self = shared_from_this()](const boost::system::error_code& error, std::size_t bytesTransferred) {
+                                         self->onWrite(error, bytesTransferred);
+                                     }));
+            return;
+        }
+        if (responseFile_) {
+            headSent_ = 0;
+            partIndex_ = 0;
+            partHeaderSent_ = 0;
+            doSendFile();
+            return;
+        }
+        // Head and body go out in a single gather write without joining them first
+        const std::string& body = responseSharedBody_ ? *responseSharedBody_ : responseBody_;
+        std::vector<boost::asio::const_buffer> buffers;
+        buffers.reserve(1 + 2 * std::max<std::size_t>(responseParts_.size(), 1));
+        buffers.push_back(boost::asio::buffer(responseHead_));
+        if (responseParts_.empty()) {
+            buffers.push_back(boost::asio::buffer(body));
+        }
+        for (const auto& part : responseParts_) {
+            if (!part.header.empty()) {
+                buffers.push_back(boost::asio::buffer(part.header));
+            }
+            buffers.push_back(boost::asio::buffer(body.data() + part.offset, static_cast<std::size_t>(part.length)));
+        }
+        boost::asio::async_write(*socket_, buffers,
+                                 boost::asio::bind_executor(strand_, [self = shared_from_this()](const boost::system::error_code& error, std::size_t bytesTransferred) {
+                                     self->onWrite(error, bytesTransferred);
+                                 }));
+    }
+
+#ifdef __linux__
+    void Connection::doSendFile() {
+        // Runs again whenever the socket becomes writable until head and file are sent
+        auto waitWritable = [this]() {
+            socket_->async_wait(boost::asio::ip::tcp::socket::wait_write,
+                                boost::asio::bind_executor(strand_, [self = shared_from_this()](const boost::system::error_code& error) {
+                                    if (error) {
+                                        self->onWrite(error, 0);
+                                    } else {
+                                        self->doSendFile();
+                                    }
+                                }));
+        };
+
+        socket_->native_non_blocking(true);
+        int socketFd = socket_->native_handle();
+        while (headSent_ < responseHead_.size()) {
+            // MSG_MORE holds the head back so the kernel coalesces it with the first file segment
+            ssize_t sent = ::send(socketFd, responseHead_.data() + headSent_, responseHead_.size() - headSent_,
+                                  MSG_MORE | MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    waitWritable();
+                    return;
+                }
+                onWrite(boost::system::error_code(errno, boost::asio::error::get_system_category()), 0);
+                return;
+            }
+            headSent_ += static_cast<std::size_t>(sent);
+        }
+
+        int fileFd = ::fileno(responseFile_->file.get());
+        for (; partIndex_ < responseParts_.size(); ++partIndex_, partHeaderSent_ = 0) {
+            BodyPart& part = responseParts_[partIndex_];
+            while (partHeaderSent_ < part.header.size()) {
+                ssize_t sent = ::send(socketFd, part.header.data() + partHeaderSent_, part.header.size() - partHeaderSent_,
+                                      MSG_MORE | MSG_NOSIGNAL);
+                if (sent < 0) {
+                    if (errno == EINTR) continue;
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                        waitWritable();
+                        return;
+                    }
+                    onWrite(boost::system::error_code(errno, boost::asio::error::get_system_category()), 0);
+                    return;
+                }
+                partHeaderSent_ += static_cast<std::size_t>(sent);
+            }
+
+            while (part.length > 0) {
+                off_t offset = static_cast<off_t>(part.offset);
+                std::size_t count = static_cast<std::size_t>(std::min<std::uint64_t>(part.length, 1u << 30));
+                ssize_t sent = ::sendfile(socketFd, fileFd, &offset, count);
+                if (sent < 0) {
+                    if (errno == EINTR) continue;
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                        waitWritable();
+                        return;
+                    }
+                    onWrite(boost::system::error_code(errno, boost::asio::error::get_system_category()), 0);
+                    return;
+                }
+                if (sent == 0) {
+                    // File shrank after the head announced its length, the message cannot be completed
+                    onWrite(boost::asio::error::eof, 0);
+                    return;
+                }
+                part.offset += static_cast<std::uint64_t>(sent);
+                part.length -= static_cast<std::uint64_t>(sent);
+            }
+        }
+        responseFile_.reset();
+        onWrite({}, 0);
+    }
+#else
+    void Connection::doSendFile() {
+        // Portable path: send the head, then the file in chunks read into fileChunk_
+        std::string_view pending;
+        while (partIndex_ < responseParts_.size() && partHeaderSent_ == responseParts_[partIndex_].header.size()
+               && responseParts_[partIndex_].length == 0) {
+            ++partIndex_;
+            partHeaderSent_ = 0;
+        }
+        if (headSent_ < responseHead_.size()) {
+            headSent_ = responseHead_.size();
+            pending = responseHead_;
+        } else if (partIndex_ == responseParts_.size()) {
+            responseFile_.reset();
+            onWrite({}, 0);
+            return;
+        } else if (BodyPart& part = responseParts_[partIndex_]; partHeaderSent_ < part.header.size()) {
+            partHeaderSent_ = part.header.size();
+            pending = part.header;
+        } else {
+            fileChunk_.resize(64 * 1024);
+            std::FILE* file = responseFile_->file.get();
+            std::size_t count = static_cast<std::size_t>(std::min<std::uint64_t>(part.length, fileChunk_.size()));
+            if (std::fseek(file, static_cast<long>(part.offset), SEEK_SET) != 0
+                || std::fread(fileChunk_.data(), 1, count, file) != count) {
+                onWrite(boost::asio::error::eof, 0);
+                return;
+            }
+            part.offset += count;
+            part.length -= count;
+            pending = std::string_view(fileChunk_.data(), count);
+        }
+        boost::asio::async_write(*socket_, boost::asio::buffer(pending.data(), pending.size()),
+                                 boost::asio::bind_executor(strand_, [self = shared_from_this()](const boost::system::error_code& error, std::size_t bytesTransferred) {
+                                     if (error) {
+                                         self->onWrite(error, bytesTransferred);
+                                     } else {
+                                         self->doSendFile();
+                                     }
+                                 }));
+    }
+#endif
+
+    void Connection::readStream() {
+        // The producer may answer on any thread or from inside read(), writing continues on the strand
+        responseStream_->read([self = shared_from_this()](const boost::system::error_code& error, std::string_view data) {
+            boost::asio::post(self->strand_, [self, error, data]() {
+                self->writeStream(error, data);
+            });
+        });
+    }
+
+    void Connection::writeStream(const boost::system::error_code& error, std::string_view data) {
+        bool last = error == boost::asio::error::eof;
+        if (error && !last) {
+            Debug::Log::error(std::format("Error producing response body: {}", error.message()), "Connection");
+            responseStream_.reset();
+            if (!streamHeadSent_) {
+                respondError("502 Bad Gateway");
+                return;
+            }
+            close(); // The client sees a truncated body
+            return;
+        }
+
+        if (headOnly_) {
+            // HEAD: the producer still runs to its end, its output is discarded without chunk framing
+            if (streamHeadSent_) {
+                if (last) {
+                    onWrite({}, 0);
+                } else {
+                    readStream();
+                }
+                return;
+            }
+            streamHeadSent_ = true;
+            boost::asio::async_write(*socket_, boost::asio::buffer(responseHead_),
+                                     boost::asio::bind_executor(strand_, [self = shared_from_this(), last](const boost::system::error_code& error, std::size_t bytesTransferred) {
+                                         if (error || last) {
+                                             self->onWrite(error, bytesTransferred);
+                                         } else {
+                                             self->readStream();
+                                         }
+                                     }));
+            return;
+        }
+
+        std::vector<boost::asio::const_buffer> buffers;
+        buffers.reserve(5);
+        if (!streamHeadSent_) {
+            streamHeadSent_ = true;
+            buffers.push_back(boost::asio::buffer(responseHead_));
+        }
+        if (!data.empty() && responseChunked_) {
+            chunkHeader_ = std::format("{:x}\r\n", data.size());
+            buffers.push_back(boost::asio::buffer(chunkHeader_));
+            buffers.push_back(boost::asio::buffer(data.data(), data.size()));
+            buffers.push_back(boost::asio::buffer("\r\n", 2));
+        } else if (!data.empty()) {
+            buffers.push_back(boost::asio::buffer(data.data(), data.size()));
+        }
+        if (last && responseChunked_) {
+            buffers.push_back(boost::asio::buffer("0\r\n\r\n", 5));
+        }
+        // The next piece is only requested once this one is out, a slow client stalls the producer
+        boost::asio::async_write(*socket_, buffers,
+                                 boost::asio::bind_executor(strand_, [self = shared_from_this(), last](const boost::system::error_code& error, std::size_t bytesTransferred) {
+                                     if (error || last) {
+                                         self->onWrite(error, bytesTransferred);
+                                     } else {
+                                         self->readStream();
+                                     }
+                                 }));
+    }
+
+    void Connection::onWrite(const boost::system::error_code& error, std::size_t) {
+        // Let go of cached bodies, files and producers while the connection idles
+        responseSharedBody_.reset();
+        responseFile_.reset();
+        responseParts_.clear();
+        responseStream_.reset();
+        if (error) {
+            Debug::Log::error(std::format("Error writing response: {}", error.message()), "Connection");
+            close();
+            return;
+        }
+        if (keepAlive_) {
+            doRead();
+        } else {
+            close();
+        }
+    }
+
+    void Connection::consume(std::size_t size) {
+        // Move pipelined bytes to the front so the next head starts at offset 0
+        std::memmove(buffer_.data(), buffer_.data() + size, buffered_ - size);
+        buffered_ -= size;
+    }
+
+    void Connection::armIdleTimer() {
+        idleTimer_.expires_after(std::chrono::seconds(handler_->getConfig()->keepAliveTimeout));
+        idleTimer_.async_wait([self = shared_from_this()](const boost::system::error_code& error) {
+            self->onIdleTimeout(error);
+        });
+    }
+
+    void Connection::onIdleTimeout(const boost::system::error_code& error) {
+        if (error == boost::asio::error::operation_aborted || !waitingForRequest_) {
+            return; // Request arrived in time
+        }
+        LOG_DEBUG("Connection", "Closing idle connection");
+        close();
+    }
+
+    void Connection::close() {
+        boost::system::error_code ec;
+        socket_->shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+        socket_->close(ec);
+    }
+
+} // namespace Network
\ No newline at end of file
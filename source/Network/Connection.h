@@ -0,0 +1,113 @@
+#ifndef CONNECTION_H
+#define CONNECTION_H
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "HttpParser.h"
+#include "HttpResponse.h"
+
+namespace Network {
+
+class RequestHandler;
+
+// A single client connection driven as an asynchronous state machine:
+// read request head -> read request body -> write response (streamed bodies piece by piece) -> read next request or close.
+// Pipelined requests left in the buffer are processed in order, one response at a time.
+class Connection : public std::enable_shared_from_this<Connection> {
+public:
+    // Initial receive buffer, grown up to HttpParser::Limits::maxHeadSize for large heads
+    static constexpr std::size_t initialBufferSize = 4 * 1024;
+
+    Connection(std::shared_ptr<boost::asio::ip::tcp::socket> socket, std::shared_ptr<RequestHandler> handler,
+               std::function<void()> onClose = {}, std::function<void()> onRequest = {});
+    ~Connection();
+
+    // Begin reading the request
+    void start();
+
+private:
+    // Parse the buffered data, reading more until a complete request head is available
+    void doRead();
+    void onRead(const boost::system::error_code& error, std::size_t bytesTransferred);
+
+    // Collect the request body announced by Content-Length, 413 beyond LimitRequestBody
+    void readBody();
+    void doReadBody();
+
+    // Build the response for the parsed request head
+    void respond();
+
+    // Answer a request that could not be parsed and close afterwards
+    void respondError(const std::string& status);
+
+    // Wait for a deferred response and run finishing work off the I/O threads, then send it
+    void deliver(HttpResponse&& response);
+
+    // Take over head and body of a finished response and start writing it
+    void setResponse(HttpResponse&& response);
+
+    // Write head and in-memory body with one gather write, or hand over to the file path
+    void doWrite();
+
+    // Send head and file parts: sendfile(2) on Linux, chunked reads elsewhere
+    void doSendFile();
+
+    // Ask the body stream for its next piece, then write it (with the head before the first one)
+    void readStream();
+    void writeStream(const boost::system::error_code& error, std::string_view data);
+    void onWrite(const boost::system::error_code& error, std::size_t bytesTransferred);
+
+    // Drop bytes from the front of the receive buffer
+    void consume(std::size_t size);
+
+    // Close the connection when no request arrives within the keep-alive timeout
+    void armIdleTimer();
+    void onIdleTimeout(const boost::system::error_code& error);
+
+    // Shut the socket down after the last response has been sent
+    void close();
+
+    std::shared_ptr<boost::asio::ip::tcp::socket> socket_;
+    std::shared_ptr<RequestHandler> handler_;
+    std::function<void()> onClose_; // Invoked once the connection is destroyed
+    std::function<void()> onRequest_; // Invoked for every request read from the connection
+    boost::asio::strand<boost::asio::any_io_executor> strand_; // Serializes socket and timer handlers
+    boost::asio::steady_timer idleTimer_;
+    std::vector<char> buffer_; // Receive buffer, request views point into it
+    std::size_t buffered_ = 0; // Bytes of buffer_ holding received data
+    HttpParser parser_;
+    HttpRequest request_;
+    std::string requestBody_; // Body of the current request, request_.body points into it
+    std::size_t bodyRead_ = 0; // Bytes of requestBody_ received
+    std::string remoteAddress_; // Peer and local address for the CGI environment
+    std::string localAddress_;
+    unsigned short remotePort_ = 0;
+    unsigned short localPort_ = 0;
+    std::string responseHead_;
+    std::string responseBody_;
+    std::shared_ptr<const std::string> responseSharedBody_; // Cached body, replaces responseBody_
+    std::optional<FileBody> responseFile_; // Body streamed from disk instead of responseBody_
+    std::vector<BodyPart> responseParts_; // Slices of the body to send, the whole file on the file path
+    std::size_t headSent_ = 0; // Bytes of responseHead_ already sent on the file path
+    std::size_t partIndex_ = 0; // Part being sent on the file path
+    std::size_t partHeaderSent_ = 0; // Bytes of its multipart header already sent
+    std::vector<char> fileChunk_; // Read buffer for the file path without sendfile
+    std::shared_ptr<BodyStream> responseStream_; // Body produced while sending, replaces responseBody_
+    bool responseChunked_ = false; // Frame responseStream_ pieces as chunks
+    bool streamHeadSent_ = false;
+    std::string chunkHeader_; // Size line of the chunk being written
+    bool keepAlive_ = false;
+    bool headOnly_ = false; // HEAD request: send the head as for GET, but no body
+    bool waitingForRequest_ = false; // A read for the next request head or its body is pending
+    int requestsServed_ = 0;
+};
+
+} // namespace Network
+
+#endif // CONNECTION_H
\ No newline at end of file
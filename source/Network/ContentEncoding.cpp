@@ -0,0 +1,87 @@
+#include "ContentEncoding.h"
+#include "HttpParser.h"
+#include <array>
+#include <utility>
+
+namespace Network {
+
+    namespace {
+        constexpr std::array<std::pair<ContentEncoding::Coding, std::string_view>, 4> codingNames = {{
+                {ContentEncoding::Brotli, "br"},
+                {ContentEncoding::Zstd, "zstd"},
+                {ContentEncoding::Gzip, "gzip"},
+                {ContentEncoding::Deflate, "deflate"},
+        }};
+
+        std::string_view trim(std::string_view value) {
+            while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+            while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.remove_suffix(1);
+            return value;
+        }
+
+        // A qvalue is "0", "0.0", "0.00" or "0.000" when the coding is refused
+        bool isZeroQuality(std::string_view parameters) {
+            while (!parameters.empty()) {
+                std::size_t semicolon = parameters.find(';');
+                std::string_view parameter = trim(parameters.substr(0, semicolon));
+                parameters.remove_prefix(semicolon == std::string_view::npos ? parameters.size() : semicolon + 1);
+                if (parameter.size() < 2 || (parameter[0] != 'q' && parameter[0] != 'Q') || parameter[1] != '=') continue;
+                std::string_view value = trim(parameter.substr(2));
+                if (value.empty() || value[0] != '0') return false;
+                return value.find_first_not_of("0.", 1) == std::string_view::npos;
+            }
+            return false;
+        }
+    }
+
+    unsigned ContentEncoding::accepted(std::string_view acceptEncoding) {
+        unsigned accepted = 0, refused = 0;
+        bool wildcard = false;
+        while (!acceptEncoding.empty()) {
+            std::size_t comma = acceptEncoding.find(',');
+            std::string_view element = acceptEncoding.substr(0, comma);
+            acceptEncoding.remove_prefix(comma == std::string_view::npos ? acceptEncoding.size() : comma + 1);
+
+            std::size_t semicolon = element.find(';');
+            std::string_view token = trim(element.substr(0, semicolon));
+            bool zero = semicolon != std::string_view::npos && isZeroQuality(element.substr(semicolon + 1));
+            if (token == "*") {
+                wildcard = !zero;
+                continue;
+            }
+            if (equalsIgnoreCase(token, "x-gzip")) token = "gzip";
+            for (const auto& [coding, name] : codingNames) {
+                if (equalsIgnoreCase(token, name)) {
+                    (zero ? refused : accepted) |= coding;
+                }
+            }
+        }
+        if (wildcard) {
+            accepted |= (Gzip | Deflate | Brotli | Zstd) & ~refused;
+        }
+        return accepted & ~refused;
+    }
+
+    ContentEncoding::Coding ContentEncoding::select(unsigned codings) {
+        for (const auto& [coding, name] : codingNames) {
+            if (codings & coding) return coding;
+        }
+        return Identity;
+    }
+
+    std::string_view ContentEncoding::name(Coding coding) {
+        for (const auto& [candidate, name] : codingNames) {
+            if (candidate == coding) return name;
+        }
+        return "identity";
+    }
+
+    std::string_view ContentEncoding::sidecarExtension(Coding coding) {
+        switch (coding) {
+            case Brotli: return ".br";
+            case Gzip: return ".gz";
+            default: return {};
+        }
+    }
+
+} // namespace Network
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef CONTENTENCODING_H
+#define CONTENTENCODING_H
+
+#include <string_view>
+
+namespace Network {
+
+// Content codings (RFC 7231 3.1.2) and Accept-Encoding negotiation
+class ContentEncoding {
+public:
+    // Codings as bit flags so accepted and available sets can be intersected
+    enum Coding : unsigned {
+        Identity = 0,
+        Gzip = 1u << 0,
+        Deflate = 1u << 1,
+        Brotli = 1u << 2,
+        Zstd = 1u << 3
+    };
+
+    // Codings with a non-zero qvalue in an Accept-Encoding value, "*" stands for all of them
+    static unsigned accepted(std::string_view acceptEncoding);
+
+    // Pick one coding out of a set, by server preference: br, zstd, gzip, deflate
+    static Coding select(unsigned codings);
+
+    // Token used in Content-Encoding
+    static std::string_view name(Coding coding);
+
+    // File name suffix of a precompressed sidecar, empty if the coding has none
+    static std::string_view sidecarExtension(Coding coding);
+};
+
+} // namespace Network
+
+#endif // CONTENTENCODING_H
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include "FastCgi.h"
+#include <algorithm>
+
+namespace Network {
+
+    namespace {
+        constexpr std::uint8_t version = 1;
+        constexpr std::uint16_t responderRole = 1;
+
+        void appendHeader(std::string& out, FastCgi::RecordType type, std::uint16_t requestId, std::size_t contentLength,
+                          std::size_t paddingLength = 0) {
+            out.push_back(static_cast<char>(version));
+            out.push_back(static_cast<char>(type));
+            out.push_back(static_cast<char>(requestId >> 8));
+            out.push_back(static_cast<char>(requestId & 0xff));
+            out.push_back(static_cast<char>(contentLength >> 8));
+            out.push_back(static_cast<char>(contentLength & 0xff));
+            out.push_back(static_cast<char>(paddingLength));
+            out.push_back(0);
+        }
+
+        void appendLength(std::string& out, std::size_t length) {
+            if (length < 128) {
+                out.push_back(static_cast<char>(length));
+            } else {
+                out.push_back(static_cast<char>(((length >> 24) & 0x7f) | 0x80));
+                out.push_back(static_cast<char>((length >> 16) & 0xff));
+                out.push_back(static_cast<char>((length >> 8) & 0xff));
+                out.push_back(static_cast<char>(length & 0xff));
+            }
+        }
+
+        void appendPair(std::string& out, std::string_view name, std::string_view value) {
+            appendLength(out, name.size());
+            appendLength(out, value.size());
+            out += name;
+            out += value;
+        }
+
+        // Split a stream into records and terminate it with an empty one
+        void appendStream(std::string& out, FastCgi::RecordType type, std::uint16_t requestId, std::string_view data) {
+            while (!data.empty()) {
+                std::size_t size = std::min(data.size(), FastCgi::maxContentLength - 7); // Keeps padding within bounds
+                FastCgi::appendRecord(out, type, requestId, data.substr(0, size));
+                data.remove_prefix(size);
+            }
+            appendHeader(out, type, requestId, 0);
+        }
+    }
+
+    void FastCgi::appendRecord(std::string& out, RecordType type, std::uint16_t requestId, std::string_view content) {
+        // Records are padded to a multiple of 8 bytes, as most applications expect
+        std::size_t padding = (8 - content.size() % 8) % 8;
+        appendHeader(out, type, requestId, content.size(), padding);
+        out.append(content);
+        out.append(padding, '\0');
+    }
+
+    void FastCgi::appendBeginRequest(std::string& out, std::uint16_t requestId, bool keepConnection) {
+        appendHeader(out, BeginRequest, requestId, 8);
+        out.push_back(static_cast<char>(responderRole >> 8));
+        out.push_back(static_cast<char>(responderRole & 0xff));
+        out.push_back(static_cast<char>(keepConnection ? 1 : 0));
+        out.append(5, '\0');
+    }
+
+    void FastCgi::appendParams(std::string& out, std::uint16_t requestId,
+                               const std::vector<std::pair<std::string, std::string>>& params) {
+        std::string stream;
+        for (const auto& [name, value] : params) {
+            appendPair(stream, name, value);
+        }
+        appendStream(out, Params, requestId, stream);
+    }
+
+    void FastCgi::appendStdin(std::string& out, std::uint16_t requestId, std::string_view data) {
+        appendStream(out, Stdin, requestId, data);
+    }
+
+    void FastCgi::appendAbortRequest(std::string& out, std::uint16_t requestId) {
+        appendRecord(out, AbortRequest, requestId, {});
+    }
+
+    void FastCgi::appendEndRequest(std::string& out, std::uint16_t requestId, std::uint32_t appStatus) {
+        appendHeader(out, EndRequest, requestId, 8);
+        out.push_back(static_cast<char>(appStatus >> 24));
+        out.push_back(static_cast<char>((appStatus >> 16) & 0xff));
+        out.push_back(static_cast<char>((appStatus >> 8) & 0xff));
+        out.push_back(static_cast<char>(appStatus & 0xff));
+        out.append(4, '\0'); // protocolStatus FCGI_REQUEST_COMPLETE and reserved bytes
+    }
+
+    void FastCgi::appendGetValues(std::string& out, const std::vector<std::string>& names) {
+        std::string content;
+        for (const auto& name : names) {
+            appendPair(content, name, {});
+        }
+        appendRecord(out, GetValues, 0, content);
+    }
+
+    bool FastCgi::parseParams(std::string_view data, std::vector<std::pair<std::string, std::string>>& params) {
+        auto readLength = [&data](std::size_t& length) {
+            if (data.empty()) {
+                return false;
+            }
+            auto byte = [&](std::size_t index) { return static_cast<std::size_t>(static_cast<std::uint8_t>(data[index])); };
+            if (byte(0) < 128) {
+                length = byte(0);
+                data.remove_prefix(1);
+                return true;
+            }
+            if (data.size() < 4) {
+                return false;
+            }
+            length = ((byte(0) & 0x7f) << 24) | (byte(1) << 16) | (byte(2) << 8) | byte(3);
+            data.remove_prefix(4);
+            return true;
+        };
+        while (!data.empty()) {
+            std::size_t nameLength, valueLength;
+            if (!readLength(nameLength) || !readLength(valueLength) || data.size() < nameLength + valueLength) {
+                return false;
+            }
+            params.emplace_back(data.substr(0, nameLength), data.substr(nameLength, valueLength));
+            data.remove_prefix(nameLength + valueLength);
+        }
+        return true;
+    }
+
+    bool FastCgi::nextRecord(std::string_view& data, Record& record) {
+        if (data.size() < headerSize) {
+            return false;
+        }
+        auto byte = [&](std::size_t index) { return static_cast<std::uint8_t>(data[index]); };
+        std::size_t contentLength = (byte(4) << 8) | byte(5);
+        std::size_t total = headerSize + contentLength + byte(6);
+        if (data.size() < total) {
+            return false;
+        }
+        record.type = static_cast<RecordType>(byte(1));
+        record.requestId = static_cast<std::uint16_t>((byte(2) << 8) | byte(3));
+        record.content = data.substr(headerSize, contentLength);
+        data.remove_prefix(total);
+        return true;
+    }
+
+    std::uint32_t FastCgi::appStatus(const Record& record) {
+        if (record.content.size() < 4) {
+            return 0;
+        }
+        auto byte = [&](std::size_t index) { return static_cast<std::uint32_t>(static_cast<std::uint8_t>(record.content[index])); };
+        return (byte(0) << 24) | (byte(1) << 16) | (byte(2) << 8) | byte(3);
+    }
+
+} // namespace Network
\ No newline at end of file
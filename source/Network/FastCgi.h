@@ -0,0 +1,73 @@
+#ifndef FASTCGI_H
+#define FASTCGI_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace Network {
+
+// FastCGI 1.0 records for the responder role: record encoding and incremental record parsing
+class FastCgi {
+public:
+    enum RecordType : std::uint8_t {
+        BeginRequest = 1,
+        AbortRequest = 2,
+        EndRequest = 3,
+        Params = 4,
+        Stdin = 5,
+        Stdout = 6,
+        Stderr = 7,
+        Data = 8,
+        GetValues = 9,
+        GetValuesResult = 10,
+        UnknownType = 11
+    };
+
+    static constexpr std::size_t headerSize = 8;
+    static constexpr std::size_t maxContentLength = 65535;
+
+    // A complete record, content points into the parsed buffer
+    struct Record {
+        RecordType type = UnknownType;
+        std::uint16_t requestId = 0;
+        std::string_view content;
+    };
+
+    // Append a single record padded to a multiple of 8 bytes, content must not exceed maxContentLength
+    static void appendRecord(std::string& out, RecordType type, std::uint16_t requestId, std::string_view content);
+
+    // Append BEGIN_REQUEST, keepConnection asks the application not to close the connection afterwards
+    static void appendBeginRequest(std::string& out, std::uint16_t requestId, bool keepConnection);
+
+    // Append name-value pairs as PARAMS records followed by the empty PARAMS record
+    static void appendParams(std::string& out, std::uint16_t requestId,
+                             const std::vector<std::pair<std::string, std::string>>& params);
+
+    // Append a STDIN stream, split into records, followed by the empty STDIN record
+    static void appendStdin(std::string& out, std::uint16_t requestId, std::string_view data);
+
+    // Append ABORT_REQUEST, the application answers with END_REQUEST for requestId
+    static void appendAbortRequest(std::string& out, std::uint16_t requestId);
+
+    // Append END_REQUEST with protocolStatus REQUEST_COMPLETE
+    static void appendEndRequest(std::string& out, std::uint16_t requestId, std::uint32_t appStatus);
+
+    // Append a GET_VALUES management record asking for the given variables (e.g. FCGI_MPXS_CONNS)
+    static void appendGetValues(std::string& out, const std::vector<std::string>& names);
+
+    // Decode the name-value pairs of a PARAMS stream or GET_VALUES_RESULT record, false if truncated
+    static bool parseParams(std::string_view data, std::vector<std::pair<std::string, std::string>>& params);
+
+    // Take the next complete record from the front of data, false if more bytes are needed
+    static bool nextRecord(std::string_view& data, Record& record);
+
+    // appStatus of an END_REQUEST record
+    static std::uint32_t appStatus(const Record& record);
+};
+
+} // namespace Network
+
+#endif // FASTCGI_H
\ No newline at end of file
@@ -0,0 +1,372 @@
+#include "FastCgiClient.h"
+#include "FastCgi.h"
+#include "../Debug/Log.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Network {
+
+    namespace {
+        constexpr std::size_t maxRequestsPerLink = 64; // Cap for the FCGI_MAX_REQS an upstream reports
+
+        // Socket path of "unix:/path" or "/path", empty for TCP addresses
+        std::string_view socketPath(std::string_view address) {
+            if (address.starts_with("unix:")) {
+                return address.substr(5);
+            }
+            return address.starts_with('/') ? address : std::string_view();
+        }
+    }
+
+    FastCgiClient::FastCgiClient(std::size_t maxConnections, std::chrono::seconds timeout)
+            : ioContext_(std::make_shared<boost::asio::io_context>()), workGuard_(boost::asio::make_work_guard(*ioContext_)),
+              maxConnections_(std::max<std::size_t>(1, maxConnections)), timeout_(timeout) {
+        // The thread shares the io_context, the client may be released from one of its own callbacks
+        thread_ = std::thread([context = ioContext_]() {
+            try {
+                context->run();
+            } catch (const std::exception& e) {
+                Debug::Log::error(std::format("FastCGI client error: {}", e.what()), "FastCgiClient");
+            }
+        });
+    }
+
+    FastCgiClient::~FastCgiClient() {
+        workGuard_.reset();
+        ioContext_->stop();
+        if (thread_.get_id() == std::this_thread::get_id()) {
+            thread_.detach();
+        } else if (thread_.joinable()) {
+            thread_.join();
+        }
+        for (auto& [address, upstream] : upstreams_) {
+            for (auto& link : upstream->links) {
+                boost::system::error_code ec;
+                link->socket.close(ec);
+            }
+        }
+    }
+
+    void FastCgiClient::request(const std::string& address, std::vector<std::pair<std::string, std::string>> params,
+                                std::string body, Handlers handlers) {
+        auto exchange = std::make_shared<Exchange>();
+        exchange->params = std::move(params);
+        exchange->body = std::move(body);
+        exchange->handlers = std::move(handlers);
+        boost::asio::post(*ioContext_, [this, address, exchange]() {
+            auto& upstream = upstreams_[address];
+            if (!upstream) {
+                upstream = std::make_unique<Upstream>();
+                upstream->address = address;
+            }
+            exchange->timer = std::make_unique<boost::asio::steady_timer>(*ioContext_, timeout_);
+            exchange->timer->async_wait([this, exchange, target = upstream.get()](const boost::system::error_code& error) {
+                if (error || exchange->done) {
+                    return;
+                }
+                if (auto link = exchange->link) {
+                    abort(link, exchange, boost::asio::error::timed_out);
+                } else {
+                    std::erase(target->pending, exchange);
+                    finish(exchange, boost::asio::error::timed_out, 0);
+                }
+            });
+            upstream->pending.push_back(exchange);
+            dispatch(*upstream);
+        });
+    }
+
+    void FastCgiClient::dispatch(Upstream& upstream) {
+        while (!upstream.pending.empty()) {
+            // Least loaded link with room, a new one while the pool is not full
+            std::shared_ptr<Link> target;
+            for (const auto& link : upstream.links) {
+                if (link->active.size() < upstream.requestsPerLink
+                    && (!target || link->active.size() < target->active.size())) {
+                    target = link;
+                }
+            }
+            if (!target || (!target->active.empty() && upstream.links.size() < maxConnections_)) {
+                if (upstream.links.size() < maxConnections_) {
+                    target = std::make_shared<Link>(*ioContext_);
+                    target->upstream = &upstream;
+                    upstream.links.push_back(target);
+                    connect(target);
+                }
+            }
+            if (!target) {
+                return; // Every connection is busy, the request waits
+            }
+            auto exchange = std::move(upstream.pending.front());
+            upstream.pending.pop_front();
+            assign(target, exchange);
+        }
+    }
+
+    void FastCgiClient::assign(const std::shared_ptr<Link>& link, const std::shared_ptr<Exchange>& exchange) {
+        std::uint16_t requestId = 1;
+        while (link->active.contains(requestId)) {
+            ++requestId;
+        }
+        exchange->requestId = requestId;
+        exchange->link = link;
+        link->active.emplace(requestId, exchange);
+
+        std::string records;
+        FastCgi::appendBeginRequest(records, requestId, true);
+        FastCgi::appendParams(records, requestId, exchange->params);
+        FastCgi::appendStdin(records, requestId, exchange->body);
+        link->writes.push_back(std::move(records));
+        if (link->connected && !link->writing) {
+            doWrite(link);
+        }
+    }
+
+    void FastCgiClient::connect(const std::shared_ptr<Link>& link) {
+        const std::string& address = link->upstream->address;
+        auto onConnect = [this, link](const boost::system::error_code& error) {
+            if (link->closed) {
+                return;
+            }
+            if (error) {
+                Debug::Log::error(std::format("Cannot connect to FastCGI upstream {}: {}", link->upstream->address,
+                                              error.message()), "FastCgiClient");
+                // The upstream is unreachable, waiting requests would only fail one connection attempt later
+                Upstream& upstream = *link->upstream;
+                auto pending = std::move(upstream.pending);
+                for (auto& exchange : pending) {
+                    finish(exchange, error, 0);
+                }
+                fail(link, error);
+                return;
+            }
+            onConnected(link);
+        };
+
+        if (auto path = socketPath(address); !path.empty()) {
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+            boost::asio::local::stream_protocol::endpoint endpoint{std::string(path)};
+            link->socket.async_connect(boost::asio::generic::stream_protocol::endpoint(endpoint), onConnect);
+#else
+            boost::asio::post(*ioContext_, [onConnect]() { onConnect(boost::asio::error::operation_not_supported); });
+#endif
+            return;
+        }
+
+        std::size_t colon = address.rfind(':');
+        if (colon == std::string::npos) {
+            boost::asio::post(*ioContext_, [onConnect]() { onConnect(boost::asio::error::invalid_argument); });
+            return;
+        }
+        std::string host = address.substr(0, colon);
+        if (host.size() > 1 && host.front() == '[' && host.back() == ']') {
+            host = host.substr(1, host.size() - 2); // [::1]:9000
+        }
+        link->tcp = true;
+        auto resolver = std::make_shared<boost::asio::ip::tcp::resolver>(*ioContext_);
+        resolver->async_resolve(host, address.substr(colon + 1),
+                                [link, resolver, onConnect](const boost::system::error_code& error,
+                                                            boost::asio::ip::tcp::resolver::results_type results) {
+            if (error || results.empty()) {
+                onConnect(error ? error : boost::asio::error::host_not_found);
+                return;
+            }
+            link->socket.async_connect(boost::asio::generic::stream_protocol::endpoint(results.begin()->endpoint()), onConnect);
+        });
+    }
+
+    void FastCgiClient::onConnected(const std::shared_ptr<Link>& link) {
+        link->connected = true;
+        if (link->tcp) {
+            boost::system::error_code ec;
+            link->socket.set_option(boost::asio::ip::tcp::no_delay(true), ec);
+        }
+        Upstream& upstream = *link->upstream;
+        if (!upstream.probed) {
+            // Ask once whether requests can share a connection, until the answer comes one at a time
+            upstream.probed = true;
+            std::string records;
+            FastCgi::appendGetValues(records, {"FCGI_MPXS_CONNS", "FCGI_MAX_REQS"});
+            link->writes.push_front(std::move(records));
+        }
+        link->buffer.resize(16 * 1024);
+        doRead(link);
+        if (!link->writes.empty()) {
+            doWrite(link);
+        }
+    }
+
+    void FastCgiClient::doWrite(const std::shared_ptr<Link>& link) {
+        link->writing = true;
+        boost::asio::async_write(link->socket, boost::asio::buffer(link->writes.front()),
+                                 [this, link](const boost::system::error_code& error, std::size_t) {
+            if (link->closed) {
+                return;
+            }
+            if (error) {
+                fail(link, error);
+                return;
+            }
+            link->writes.pop_front();
+            link->writing = false;
+            if (!link->writes.empty()) {
+                doWrite(link);
+            }
+        });
+    }
+
+    void FastCgiClient::doRead(const std::shared_ptr<Link>& link) {
+        if (link->buffered == link->buffer.size()) {
+            link->buffer.resize(link->buffer.size() * 2);
+        }
+        link->socket.async_read_some(boost::asio::buffer(link->buffer.data() + link->buffered, link->buffer.size() - link->buffered),
+                                     [this, link](const boost::system::error_code& error, std::size_t bytesTransferred) {
+            if (link->closed) {
+                return;
+            }
+            if (error) {
+                // EOF on an idle connection is the upstream closing it, anything else fails its requests
+                fail(link, error);
+                return;
+            }
+            link->buffered += bytesTransferred;
+            onRecords(link);
+            if (!link->closed) {
+                doRead(link);
+            }
+        });
+    }
+
+    void FastCgiClient::onRecords(const std::shared_ptr<Link>& link) {
+        Upstream& upstream = *link->upstream;
+        std::string_view data(link->buffer.data(), link->buffered);
+        FastCgi::Record record;
+        bool released = false;
+        while (FastCgi::nextRecord(data, record)) {
+            if (record.requestId == 0) {
+                if (record.type == FastCgi::GetValuesResult) {
+                    std::vector<std::pair<std::string, std::string>> values;
+                    FastCgi::parseParams(record.content, values);
+                    bool multiplexed = false;
+                    std::size_t maxRequests = maxRequestsPerLink;
+                    for (const auto& [name, value] : values) {
+                        if (name == "FCGI_MPXS_CONNS") {
+                            multiplexed = value == "1";
+                        } else if (name == "FCGI_MAX_REQS" && !value.empty()) {
+                            maxRequests = std::clamp<std::size_t>(std::strtoul(value.c_str(), nullptr, 10), 1, maxRequestsPerLink);
+                        }
+                    }
+                    upstream.requestsPerLink = multiplexed ? maxRequests : 1;
+                    Debug::Log::info(std::format("FastCGI upstream {} {}", upstream.address,
+                                                 multiplexed ? std::format("multiplexes up to {} requests per connection", maxRequests)
+                                                             : std::string("serves one request per connection")), "FastCgiClient");
+                    released = true;
+                }
+                continue;
+            }
+            auto it = link->active.find(record.requestId);
+            if (it == link->active.end()) {
+                continue; // Not a request of this connection
+            }
+            auto exchange = it->second;
+            if (exchange->aborted && record.type != FastCgi::EndRequest) {
+                continue; // Late output of a request given up on
+            }
+            if (record.type == FastCgi::Stdout) {
+                exchange->responded = true;
+                if (!record.content.empty() && exchange->handlers.onOutput && !exchange->handlers.onOutput(record.content)) {
+                    abort(link, exchange, boost::asio::error::no_buffer_space);
+                    if (link->closed) {
+                        return;
+                    }
+                }
+            } else if (record.type == FastCgi::Stderr) {
+                exchange->responded = true;
+                if (!record.content.empty() && exchange->handlers.onErrors) {
+                    exchange->handlers.onErrors(record.content);
+                }
+            } else if (record.type == FastCgi::EndRequest) {
+                link->active.erase(it);
+                exchange->link.reset();
+                finish(exchange, {}, FastCgi::appStatus(record));
+                released = true;
+                if (link->onlyAborted()) {
+                    fail(link, boost::asio::error::operation_aborted); // Do not keep a connection for requests nobody waits for
+                    return;
+                }
+            }
+        }
+        // Keep the partial record at the front
+        std::size_t consumed = link->buffered - data.size();
+        std::memmove(link->buffer.data(), link->buffer.data() + consumed, data.size());
+        link->buffered = data.size();
+        if (released) {
+            dispatch(upstream);
+        }
+    }
+
+    void FastCgiClient::abort(const std::shared_ptr<Link>& link, const std::shared_ptr<Exchange>& exchange,
+                              const boost::system::error_code& error) {
+        Debug::Log::error(std::format("FastCGI request to {} aborted: {}", link->upstream->address, error.message()), "FastCgiClient");
+        exchange->aborted = true;
+        finish(exchange, error, 0);
+        if (link->onlyAborted()) {
+            // Nothing else runs on the connection, closing it also stops the upstream
+            fail(link, error);
+            return;
+        }
+        // Requests multiplexed next to it carry on, the id is reused once the upstream ends this one
+        std::string records;
+        FastCgi::appendAbortRequest(records, exchange->requestId);
+        link->writes.push_back(std::move(records));
+        if (link->connected && !link->writing) {
+            doWrite(link);
+        }
+    }
+
+    void FastCgiClient::fail(const std::shared_ptr<Link>& link, const boost::system::error_code& error) {
+        if (link->closed) {
+            return;
+        }
+        link->closed = true;
+        boost::system::error_code ec;
+        link->socket.close(ec);
+        Upstream& upstream = *link->upstream;
+        std::erase(upstream.links, link);
+
+        // A kept-alive connection may have been closed by the upstream just as a request was sent on it
+        auto active = std::move(link->active);
+        for (auto it = active.rbegin(); it != active.rend(); ++it) {
+            auto& exchange = it->second;
+            exchange->link.reset();
+            if (exchange->done) {
+                continue;
+            }
+            if (!exchange->responded && !exchange->retried && error != boost::asio::error::timed_out) {
+                exchange->retried = true;
+                upstream.pending.push_front(exchange);
+            } else {
+                Debug::Log::error(std::format("FastCGI request to {} failed: {}", upstream.address, error.message()), "FastCgiClient");
+                finish(exchange, error, 0);
+            }
+        }
+        dispatch(upstream);
+    }
+
+    void FastCgiClient::finish(const std::shared_ptr<Exchange>& exchange, const boost::system::error_code& error,
+                               std::uint32_t appStatus) {
+        if (exchange->done) {
+            return;
+        }
+        exchange->done = true;
+        exchange->timer->cancel();
+        if (exchange->handlers.onComplete) {
+            exchange->handlers.onComplete(error, appStatus);
+        }
+        // The callbacks may hold the last reference to the client, drop them from a fresh handler
+        boost::asio::post(*ioContext_, [handlers = std::move(exchange->handlers)]() {});
+        exchange->params.clear();
+        exchange->body.clear();
+    }
+
+} // namespace Network
\ No newline at end of file
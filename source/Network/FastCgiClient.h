@@ -0,0 +1,122 @@
+#ifndef FASTCGICLIENT_H
+#define FASTCGICLIENT_H
+
+#include <boost/asio.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Network {
+
+// Client for external FastCGI applications such as php-fpm, shared by all projects. Keeps a pool of
+// FCGI_KEEP_CONN connections per upstream address and multiplexes requests over them when the
+// upstream reports FCGI_MPXS_CONNS. All I/O runs on the client's own thread.
+class FastCgiClient {
+public:
+    // Called on the client's thread. onOutput receives FCGI_STDOUT data as it arrives and returns false
+    // to give up on the request (its connection is shared and cannot wait), onComplete runs once
+    struct Handlers {
+        std::function<bool(std::string_view data)> onOutput;
+        std::function<void(std::string_view data)> onErrors;
+        std::function<void(const boost::system::error_code& error, std::uint32_t appStatus)> onComplete;
+    };
+
+    // Up to maxConnections connections per upstream, requests not finished within timeout fail with timed_out
+    explicit FastCgiClient(std::size_t maxConnections = 16, std::chrono::seconds timeout = std::chrono::seconds(30));
+    ~FastCgiClient();
+
+    FastCgiClient(const FastCgiClient&) = delete;
+    FastCgiClient& operator=(const FastCgiClient&) = delete;
+
+    // Send a responder request to address: "host:port", "unix:/path" or an absolute socket path
+    void request(const std::string& address, std::vector<std::pair<std::string, std::string>> params, std::string body,
+                 Handlers handlers);
+
+private:
+    struct Upstream;
+    struct Link;
+
+    // One request from queueing to END_REQUEST
+    struct Exchange {
+        std::vector<std::pair<std::string, std::string>> params;
+        std::string body;
+        Handlers handlers;
+        std::unique_ptr<boost::asio::steady_timer> timer;
+        std::shared_ptr<Link> link;
+        std::uint16_t requestId = 0;
+        bool responded = false; // Some output arrived, the request cannot be retried
+        bool aborted = false;   // Given up on, its id stays taken until the upstream's END_REQUEST
+        bool retried = false;
+        bool done = false;
+    };
+
+    // One upstream connection with the requests running on it
+    struct Link {
+        explicit Link(boost::asio::io_context& ioContext) : socket(ioContext) {}
+
+        // Requests are running and all of them were given up on
+        bool onlyAborted() const {
+            return !active.empty() && std::ranges::all_of(active, [](const auto& entry) { return entry.second->aborted; });
+        }
+
+        boost::asio::generic::stream_protocol::socket socket;
+        Upstream* upstream = nullptr;
+        std::map<std::uint16_t, std::shared_ptr<Exchange>> active;
+        std::deque<std::string> writes;
+        std::string buffer;
+        std::size_t buffered = 0;
+        bool tcp = false;
+        bool connected = false;
+        bool writing = false;
+        bool closed = false;
+    };
+
+    // Connections and waiting requests of one address
+    struct Upstream {
+        std::string address;
+        std::vector<std::shared_ptr<Link>> links;
+        std::deque<std::shared_ptr<Exchange>> pending;
+        std::size_t requestsPerLink = 1; // Above 1 once the upstream reported FCGI_MPXS_CONNS
+        bool probed = false;             // FCGI_GET_VALUES was sent
+    };
+
+    // Start pending requests on links with room, opening new links up to maxConnections_
+    void dispatch(Upstream& upstream);
+    void assign(const std::shared_ptr<Link>& link, const std::shared_ptr<Exchange>& exchange);
+
+    void connect(const std::shared_ptr<Link>& link);
+    void onConnected(const std::shared_ptr<Link>& link);
+    void doWrite(const std::shared_ptr<Link>& link);
+    void doRead(const std::shared_ptr<Link>& link);
+    void onRecords(const std::shared_ptr<Link>& link);
+
+    // Give up on a request running on link without disturbing the others there, it completes with error
+    void abort(const std::shared_ptr<Link>& link, const std::shared_ptr<Exchange>& exchange, const boost::system::error_code& error);
+
+    // Close a link, requests without any output yet are retried once on another link
+    void fail(const std::shared_ptr<Link>& link, const boost::system::error_code& error);
+
+    // Finish a request once and release its callbacks outside the client's frames
+    void finish(const std::shared_ptr<Exchange>& exchange, const boost::system::error_code& error, std::uint32_t appStatus);
+
+    std::shared_ptr<boost::asio::io_context> ioContext_; // Shared with thread_, which may outlive the client
+    boost::asio::executor_work_guard<boost::asio::io_context::executor_type> workGuard_;
+    std::size_t maxConnections_;
+    std::chrono::seconds timeout_;
+    std::unordered_map<std::string, std::unique_ptr<Upstream>> upstreams_;
+    std::thread thread_;
+};
+
+} // namespace Network
+
+#endif // FASTCGICLIENT_H
\ No newline at end of file
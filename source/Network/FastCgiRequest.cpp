@@ -0,0 +1,172 @@
+#include "FastCgiRequest.h"
+#include "FastCgi.h"
+#include <cstring>
+
+namespace Network {
+
+    void FastCgiRequest::start(boost::asio::io_context& ioContext, const std::string& endpoint, std::string records,
+                               std::chrono::milliseconds connectWindow, std::chrono::seconds timeout, Callback callback,
+                               Output output) {
+        auto request = std::make_shared<FastCgiRequest>(ioContext, endpoint, std::move(records), connectWindow, timeout,
+                                                        std::move(callback), std::move(output));
+        request->resume_ = [weak = std::weak_ptr<FastCgiRequest>(request)]() {
+            // The deadline timer keeps a paused request alive
+            if (auto self = weak.lock()) {
+                boost::asio::post(self->timer_.get_executor(), [self]() { self->resume(); });
+            }
+        };
+        boost::asio::dispatch(ioContext, [request]() {
+            request->startTimer();
+            request->doConnect();
+        });
+    }
+
+    void FastCgiRequest::startTimer() {
+        timer_.expires_after(timeout_);
+        timer_.async_wait([self = shared_from_this()](const boost::system::error_code& error) {
+            if (!error) {
+                self->complete(boost::asio::error::timed_out);
+            }
+        });
+    }
+
+    FastCgiRequest::FastCgiRequest(boost::asio::io_context& ioContext, const std::string& endpoint, std::string records,
+                                   std::chrono::milliseconds connectWindow, std::chrono::seconds timeout, Callback callback,
+                                   Output output)
+            :
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+              socket_(ioContext),
+#endif
+              timer_(ioContext), retryTimer_(ioContext), endpoint_(endpoint), records_(std::move(records)),
+              connectDeadline_(std::chrono::steady_clock::now() + connectWindow), timeout_(timeout),
+              callback_(std::move(callback)), output_(std::move(output)), buffer_(16 * 1024, '\0') {
+    }
+
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+    void FastCgiRequest::doConnect() {
+        socket_.async_connect(boost::asio::local::stream_protocol::endpoint(endpoint_),
+                              [self = shared_from_this()](const boost::system::error_code& error) {
+            if (self->done_) {
+                return;
+            }
+            if (!error) {
+                self->doWrite();
+                return;
+            }
+            bool starting = error == boost::asio::error::connection_refused || error == boost::asio::error::not_found
+                            || error == boost::system::errc::no_such_file_or_directory;
+            if (!starting || std::chrono::steady_clock::now() >= self->connectDeadline_) {
+                self->complete(error);
+                return;
+            }
+            // The worker has not bound its socket yet
+            boost::system::error_code ec;
+            self->socket_.close(ec);
+            self->retryTimer_.expires_after(std::chrono::milliseconds(20));
+            self->retryTimer_.async_wait([self](const boost::system::error_code& error) {
+                if (!error && !self->done_) {
+                    self->doConnect();
+                }
+            });
+        });
+    }
+
+    void FastCgiRequest::doWrite() {
+        boost::asio::async_write(socket_, boost::asio::buffer(records_),
+                                 [self = shared_from_this()](const boost::system::error_code& error, std::size_t) {
+            if (error) {
+                self->complete(error);
+                return;
+            }
+            self->records_.clear();
+            self->doRead();
+        });
+    }
+
+    void FastCgiRequest::doRead() {
+        if (buffered_ == buffer_.size()) {
+            buffer_.resize(buffer_.size() * 2);
+        }
+        socket_.async_read_some(boost::asio::buffer(buffer_.data() + buffered_, buffer_.size() - buffered_),
+                                [self = shared_from_this()](const boost::system::error_code& error, std::size_t bytesTransferred) {
+            if (self->done_) {
+                return;
+            }
+            if (error) {
+                // EOF before END_REQUEST means the worker died mid-request
+                self->complete(error);
+                return;
+            }
+            self->buffered_ += bytesTransferred;
+            std::string_view data(self->buffer_.data(), self->buffered_);
+            FastCgi::Record record;
+            while (FastCgi::nextRecord(data, record)) {
+                if (record.type == FastCgi::Stdout && self->output_) {
+                    if (!record.content.empty() && !self->output_(record.content, self->resume_)) {
+                        self->paused_ = true; // The records already received are still delivered
+                    }
+                } else if (record.type == FastCgi::Stdout) {
+                    self->result_.output.append(record.content);
+                } else if (record.type == FastCgi::Stderr) {
+                    self->result_.errors.append(record.content);
+                } else if (record.type == FastCgi::EndRequest) {
+                    self->result_.appStatus = FastCgi::appStatus(record);
+                    self->complete({});
+                    return;
+                }
+            }
+            // Keep the partial record at the front
+            std::size_t consumed = self->buffered_ - data.size();
+            std::memmove(self->buffer_.data(), self->buffer_.data() + consumed, data.size());
+            self->buffered_ = data.size();
+            if (!self->paused_) {
+                self->doRead();
+            }
+        });
+    }
+
+    void FastCgiRequest::resume() {
+        if (done_ || !paused_) {
+            return;
+        }
+        paused_ = false;
+        startTimer(); // A slow client does not count against the script
+        doRead();
+    }
+
+    void FastCgiRequest::complete(const boost::system::error_code& error) {
+        if (done_) {
+            return;
+        }
+        done_ = true;
+        boost::system::error_code ec;
+        socket_.close(ec);
+        timer_.cancel();
+        retryTimer_.cancel();
+        callback_(error, std::move(result_));
+    }
+#else
+    void FastCgiRequest::doConnect() {
+        complete(boost::asio::error::operation_not_supported);
+    }
+
+    void FastCgiRequest::doWrite() {
+    }
+
+    void FastCgiRequest::doRead() {
+    }
+
+    void FastCgiRequest::resume() {
+    }
+
+    void FastCgiRequest::complete(const boost::system::error_code& error) {
+        if (done_) {
+            return;
+        }
+        done_ = true;
+        timer_.cancel();
+        callback_(error, std::move(result_));
+    }
+#endif
+
+} // namespace Network
\ No newline at end of file
@@ -0,0 +1,74 @@
+#ifndef FASTCGIREQUEST_H
+#define FASTCGIREQUEST_H
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace Network {
+
+// One FastCGI request sent over its own connection to a unix socket (a php-cgi -b worker).
+// STDOUT is collected and handed to the callback on the socket's executor, or passed to an
+// output handler record by record.
+class FastCgiRequest : public std::enable_shared_from_this<FastCgiRequest> {
+public:
+    struct Result {
+        std::string output;    // STDOUT: CGI headers and body
+        std::string errors;    // STDERR
+        std::uint32_t appStatus = 0;
+    };
+    using Callback = std::function<void(const boost::system::error_code& error, Result&& result)>;
+    // Returning false stops reading the socket until resume is called, from any thread
+    using Output = std::function<bool(std::string_view data, const std::function<void()>& resume)>;
+
+    // Connect and send pre-encoded records (BEGIN_REQUEST, PARAMS, STDIN). Connection attempts are
+    // repeated until connectWindow has passed, for workers that are still starting up. With output
+    // set, STDOUT goes there as it arrives and Result::output stays empty
+    static void start(boost::asio::io_context& ioContext, const std::string& endpoint, std::string records,
+                      std::chrono::milliseconds connectWindow, std::chrono::seconds timeout, Callback callback,
+                      Output output = {});
+
+    FastCgiRequest(boost::asio::io_context& ioContext, const std::string& endpoint, std::string records,
+                   std::chrono::milliseconds connectWindow, std::chrono::seconds timeout, Callback callback,
+                   Output output = {});
+
+private:
+    // (Re)start the request deadline
+    void startTimer();
+
+    void doConnect();
+    void doWrite();
+    void doRead();
+
+    // Continue reading after output_ asked to pause
+    void resume();
+
+    // Finish once, closing the socket and stopping the timers
+    void complete(const boost::system::error_code& error);
+
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+    boost::asio::local::stream_protocol::socket socket_;
+#endif
+    boost::asio::steady_timer timer_;      // Request deadline, restarted when a paused output resumes
+    boost::asio::steady_timer retryTimer_; // Delay between connection attempts
+    std::string endpoint_;
+    std::string records_;
+    std::chrono::steady_clock::time_point connectDeadline_;
+    std::chrono::seconds timeout_;
+    Callback callback_;
+    Output output_;
+    std::function<void()> resume_; // Handed to output_, holds the request weakly
+    std::string buffer_; // Received bytes not yet parsed into records
+    std::size_t buffered_ = 0;
+    Result result_;
+    bool done_ = false;
+    bool paused_ = false;
+};
+
+} // namespace Network
+
+#endif // FASTCGIREQUEST_H
\ No newline at end of file
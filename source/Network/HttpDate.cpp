@@ -0,0 +1,71 @@
+#include "HttpDate.h"
+#include <array>
+#include <chrono>
+#include <cstdio>
+
+namespace Network {
+
+    namespace {
+        constexpr std::array<const char*, 7> weekdayNames = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+        constexpr std::array<const char*, 12> monthNames = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                                            "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+        // Parse exactly count digits
+        bool parseNumber(std::string_view value, std::size_t offset, std::size_t count, int& result) {
+            result = 0;
+            for (std::size_t i = offset; i < offset + count; ++i) {
+                if (value[i] < '0' || value[i] > '9') return false;
+                result = result * 10 + (value[i] - '0');
+            }
+            return true;
+        }
+    }
+
+    std::string HttpDate::format(std::time_t time) {
+        using namespace std::chrono;
+        sys_seconds point{seconds{time}};
+        sys_days day = floor<days>(point);
+        year_month_day date{day};
+        hh_mm_ss<seconds> clock{point - day};
+
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%s, %02u %s %04d %02d:%02d:%02d GMT",
+                      weekdayNames[weekday{day}.c_encoding()], static_cast<unsigned>(date.day()),
+                      monthNames[static_cast<unsigned>(date.month()) - 1], static_cast<int>(date.year()),
+                      static_cast<int>(clock.hours().count()), static_cast<int>(clock.minutes().count()),
+                      static_cast<int>(clock.seconds().count()));
+        return buffer;
+    }
+
+    std::optional<std::time_t> HttpDate::parse(std::string_view value) {
+        // "Sun, 06 Nov 1994 08:49:37 GMT"
+        if (value.size() != 29 || value.substr(3, 2) != ", " || value[7] != ' ' || value[11] != ' '
+            || value[16] != ' ' || value[19] != ':' || value[22] != ':' || value.substr(25) != " GMT") {
+            return std::nullopt;
+        }
+        int day, year, hours, minutes, seconds;
+        if (!parseNumber(value, 5, 2, day) || !parseNumber(value, 12, 4, year) || !parseNumber(value, 17, 2, hours)
+            || !parseNumber(value, 20, 2, minutes) || !parseNumber(value, 23, 2, seconds)) {
+            return std::nullopt;
+        }
+        unsigned month = 0;
+        while (month < monthNames.size() && value.substr(8, 3) != monthNames[month]) ++month;
+        if (month == monthNames.size() || hours > 23 || minutes > 59 || seconds > 60) {
+            return std::nullopt;
+        }
+
+        using namespace std::chrono;
+        year_month_day date{std::chrono::year{year}, std::chrono::month{month + 1}, std::chrono::day{static_cast<unsigned>(day)}};
+        if (!date.ok()) {
+            return std::nullopt;
+        }
+        sys_seconds point = sys_days{date} + std::chrono::hours{hours} + std::chrono::minutes{minutes} + std::chrono::seconds{seconds};
+        return static_cast<std::time_t>(point.time_since_epoch().count());
+    }
+
+    std::time_t HttpDate::fromFileTime(std::filesystem::file_time_type time) {
+        auto point = std::chrono::clock_cast<std::chrono::system_clock>(time);
+        return std::chrono::system_clock::to_time_t(std::chrono::time_point_cast<std::chrono::system_clock::duration>(point));
+    }
+
+} // namespace Network
\ No newline at end of file
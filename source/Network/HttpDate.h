@@ -0,0 +1,27 @@
+#ifndef HTTPDATE_H
+#define HTTPDATE_H
+
+#include <ctime>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace Network {
+
+// HTTP-date handling (RFC 7231 7.1.1.1), always in the IMF-fixdate form
+class HttpDate {
+public:
+    // Format a UTC time, e.g. "Sun, 06 Nov 1994 08:49:37 GMT"
+    static std::string format(std::time_t time);
+
+    // Parse an IMF-fixdate, empty if the value is in another or a malformed form
+    static std::optional<std::time_t> parse(std::string_view value);
+
+    // Seconds since the epoch of a file modification time
+    static std::time_t fromFileTime(std::filesystem::file_time_type time);
+};
+
+} // namespace Network
+
+#endif // HTTPDATE_H
\ No newline at end of file
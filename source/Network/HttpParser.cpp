@@ -0,0 +1,174 @@
+#include "HttpParser.h"
+#include "HttpScan.h"
+#include <charconv>
+
+namespace Network {
+
+    namespace {
+        std::string_view trim(std::string_view value) {
+            while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+            while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.remove_suffix(1);
+            return value;
+        }
+    }
+
+    bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) return false;
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            char x = a[i], y = b[i];
+            if (x >= 'A' && x <= 'Z') x = static_cast<char>(x - 'A' + 'a');
+            if (y >= 'A' && y <= 'Z') y = static_cast<char>(y - 'A' + 'a');
+            if (x != y) return false;
+        }
+        return true;
+    }
+
+    std::string_view HttpRequest::header(std::string_view name) const {
+        for (const auto& field : headers) {
+            if (equalsIgnoreCase(field.name, name)) return field.value;
+        }
+        return {};
+    }
+
+    std::string_view HttpRequest::path() const {
+        return target.substr(0, target.find('?'));
+    }
+
+    std::string_view HttpRequest::query() const {
+        std::size_t position = target.find('?');
+        return position == std::string_view::npos ? std::string_view() : target.substr(position + 1);
+    }
+
+    bool HttpRequest::keepAlive() const {
+        // Connection is a comma separated list of options
+        std::string_view connection = header("Connection");
+        bool close = false, keepAlive = false;
+        while (!connection.empty()) {
+            std::size_t comma = connection.find(',');
+            std::string_view option = trim(connection.substr(0, comma));
+            close = close || equalsIgnoreCase(option, "close");
+            keepAlive = keepAlive || equalsIgnoreCase(option, "keep-alive");
+            connection.remove_prefix(comma == std::string_view::npos ? connection.size() : comma + 1);
+        }
+        if (close) return false;
+        return version == "HTTP/1.1" || keepAlive;
+    }
+
+    void HttpRequest::clear() {
+        method = target = version = {};
+        headers.clear();
+        contentLength = 0;
+        body = remoteAddress = localAddress = {};
+        remotePort = localPort = 0;
+    }
+
+    HttpParser::Result HttpParser::parse(std::string_view data, HttpRequest& request) {
+        if (headSize_ == 0) {
+            std::size_t end = findHeadEnd(data);
+            if (end == 0) {
+                return data.size() > limits_.maxHeadSize ? Result::HeadTooLarge : Result::Incomplete;
+            }
+            if (end > limits_.maxHeadSize) {
+                return Result::HeadTooLarge;
+            }
+            headSize_ = end;
+        }
+        return parseHead(data.substr(0, headSize_), request);
+    }
+
+    void HttpParser::reset() {
+        scanned_ = 0;
+        headSize_ = 0;
+    }
+
+    std::size_t HttpParser::findHeadEnd(std::string_view data) {
+        // The head ends with an empty line, accept bare LF line endings as well
+        std::size_t position = scanned_;
+        while ((position = data.find('\n', position)) != std::string_view::npos) {
+            if (position + 1 < data.size() && data[position + 1] == '\n') {
+                return position + 2;
+            }
+            if (position + 2 < data.size() && data[position + 1] == '\r' && data[position + 2] == '\n') {
+                return position + 3;
+            }
+            ++position;
+        }
+        // The terminator may straddle the next read, keep its possible start
+        scanned_ = data.size() >= 2 ? data.size() - 2 : 0;
+        return 0;
+    }
+
+    HttpParser::Result HttpParser::parseHead(std::string_view head, HttpRequest& request) const {
+        request.clear();
+        const char* position = head.data();
+        const char* end = head.data() + head.size();
+
+        // Consume CRLF or bare LF, anything else means a stray control character
+        auto endLine = [&]() {
+            if (position < end && *position == '\r') ++position;
+            if (position == end || *position != '\n') return false;
+            ++position;
+            return true;
+        };
+
+        // Tolerate empty lines before the request line (RFC 7230 3.5)
+        while (position < end && (*position == '\r' || *position == '\n')) ++position;
+
+        // Request line: method SP request-target SP HTTP-version
+        std::size_t length = HttpScan::findTokenEnd(position, end - position);
+        if (length == 0 || position + length == end || position[length] != ' ') {
+            return Result::Invalid;
+        }
+        request.method = std::string_view(position, length);
+        position += length + 1;
+
+        std::string_view line(position, HttpScan::findLineEnd(position, end - position));
+        std::size_t space = line.find(' ');
+        if (space == 0 || space == std::string_view::npos) {
+            return Result::Invalid;
+        }
+        request.target = line.substr(0, space);
+        request.version = line.substr(space + 1);
+        position += line.size();
+        if (!request.version.starts_with("HTTP/1.") || request.version.size() != 8 || !endLine()) {
+            return Result::Invalid;
+        }
+
+        // Header fields: token ':' OWS value OWS, up to the empty line
+        bool hasContentLength = false;
+        while (position < end && *position != '\r' && *position != '\n') {
+            length = HttpScan::findTokenEnd(position, end - position);
+            if (length == 0 || position + length == end || position[length] != ':') {
+                return Result::Invalid; // Also rejects obsolete line folding
+            }
+            if (request.headers.size() == limits_.maxHeaders) {
+                return Result::TooManyHeaders;
+            }
+            std::string_view name(position, length);
+            position += length + 1;
+            while (position < end && (*position == ' ' || *position == '\t')) ++position;
+            std::string_view value(position, HttpScan::findLineEnd(position, end - position));
+            position += value.size();
+            if (!endLine()) {
+                return Result::Invalid;
+            }
+            HttpHeader& field = request.headers.emplace_back(HttpHeader{name, trim(value)});
+
+            if (equalsIgnoreCase(field.name, "Content-Length")) {
+                std::size_t contentLength = 0;
+                auto [last, error] = std::from_chars(field.value.data(), field.value.data() + field.value.size(), contentLength);
+                if (error != std::errc() || last != field.value.data() + field.value.size()
+                    || (hasContentLength && contentLength != request.contentLength)) {
+                    return Result::Invalid;
+                }
+                request.contentLength = contentLength;
+                hasContentLength = true;
+            } else if (equalsIgnoreCase(field.name, "Transfer-Encoding") && !equalsIgnoreCase(field.value, "identity")) {
+                // Chunked request bodies are not supported, refuse instead of losing the message boundary
+                return Result::Invalid;
+            }
+        }
+        return Result::Complete;
+    }
+
+} // namespace Network
\ No newline at end of file
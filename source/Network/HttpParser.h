@@ -0,0 +1,96 @@
+#ifndef HTTPPARSER_H
+#define HTTPPARSER_H
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace Network {
+
+// Header field as views into the receive buffer
+struct HttpHeader {
+    std::string_view name;
+    std::string_view value;
+};
+
+// Parsed request head. All views point into the buffer passed to HttpParser::parse
+// and stay valid as long as that buffer is not modified.
+struct HttpRequest {
+    std::string_view method;
+    std::string_view target;  // Request target as sent, including the query string
+    std::string_view version; // e.g. "HTTP/1.1"
+    std::vector<HttpHeader> headers;
+    std::size_t contentLength = 0;
+
+    // Filled by the connection, not the parser: the body once it was read and the socket addresses
+    std::string_view body;
+    std::string_view remoteAddress;
+    unsigned short remotePort = 0;
+    std::string_view localAddress;
+    unsigned short localPort = 0;
+
+    // Value of the first header with this name (case-insensitive), empty if absent
+    std::string_view header(std::string_view name) const;
+
+    // Target without the query string
+    std::string_view path() const;
+
+    // Query string without the leading '?'
+    std::string_view query() const;
+
+    // Persistent connection requested (HTTP/1.1 default, HTTP/1.0 via Connection: keep-alive)
+    bool keepAlive() const;
+
+    void clear();
+};
+
+// Case-insensitive comparison of ASCII tokens
+bool equalsIgnoreCase(std::string_view a, std::string_view b);
+
+// Incremental HTTP/1.x request head parser working directly on the receive buffer.
+// Call parse() with the whole buffered data after every read; bytes already checked
+// for the end of the head are not scanned again.
+class HttpParser {
+public:
+    enum class Result {
+        Complete,       // Head parsed, headSize() bytes belong to it
+        Incomplete,     // Need more data
+        Invalid,        // Malformed request
+        HeadTooLarge,   // Head exceeds maxHeadSize
+        TooManyHeaders  // More than maxHeaders header fields
+    };
+
+    struct Limits {
+        std::size_t maxHeadSize = 16 * 1024;
+        std::size_t maxHeaders = 64;
+    };
+
+    HttpParser() = default;
+    explicit HttpParser(Limits limits) : limits_(limits) {}
+
+    // Parse the request head at the start of data, filling request on Complete
+    Result parse(std::string_view data, HttpRequest& request);
+
+    // Size of the last complete head including the terminating empty line
+    std::size_t headSize() const { return headSize_; }
+
+    // Forget the progress of the current head, call after consuming it
+    void reset();
+
+    const Limits& limits() const { return limits_; }
+
+private:
+    // Find the end of the head, returns its size or 0 if not yet received
+    std::size_t findHeadEnd(std::string_view data);
+
+    // Split a complete head into request line and header fields
+    Result parseHead(std::string_view head, HttpRequest& request) const;
+
+    Limits limits_;
+    std::size_t scanned_ = 0; // Bytes already searched for the end of the head
+    std::size_t headSize_ = 0;
+};
+
+} // namespace Network
+
+#endif // HTTPPARSER_H
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "HttpRange.h"
+#include <algorithm>
+
+namespace Network {
+
+    namespace {
+        std::string_view trim(std::string_view value) {
+            while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+            while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.remove_suffix(1);
+            return value;
+        }
+
+        // Parse a non-empty run of digits, false on anything else or overflow
+        bool parseNumber(std::string_view value, std::uint64_t& result) {
+            if (value.empty() || value.size() > 19) return false;
+            result = 0;
+            for (char c : value) {
+                if (c < '0' || c > '9') return false;
+                result = result * 10 + static_cast<std::uint64_t>(c - '0');
+            }
+            return true;
+        }
+    }
+
+    HttpRange::Result HttpRange::parse(std::string_view value, std::uint64_t size, std::vector<ByteRange>& ranges) {
+        ranges.clear();
+        value = trim(value);
+        if (!value.starts_with("bytes=")) {
+            return Result::Ignore;
+        }
+        value.remove_prefix(6);
+
+        bool any = false;
+        while (!value.empty()) {
+            std::size_t comma = value.find(',');
+            std::string_view spec = trim(value.substr(0, comma));
+            value = comma == std::string_view::npos ? std::string_view() : value.substr(comma + 1);
+            if (spec.empty()) {
+                continue; // Empty list elements are allowed
+            }
+            std::size_t dash = spec.find('-');
+            if (dash == std::string_view::npos) {
+                return Result::Ignore;
+            }
+            any = true;
+
+            std::uint64_t first, last;
+            if (dash == 0) {
+                // Suffix range: the final n bytes
+                if (!parseNumber(spec.substr(1), last)) return Result::Ignore;
+                if (last == 0 || size == 0) continue;
+                std::uint64_t length = std::min(last, size);
+                ranges.push_back({size - length, length});
+                continue;
+            }
+            if (!parseNumber(spec.substr(0, dash), first)) return Result::Ignore;
+            if (dash + 1 == spec.size()) {
+                last = size - 1;
+            } else if (!parseNumber(spec.substr(dash + 1), last) || last < first) {
+                return Result::Ignore;
+            }
+            if (first >= size) continue;
+            last = std::min(last, size - 1);
+            ranges.push_back({first, last - first + 1});
+        }
+        if (!any) {
+            return Result::Ignore;
+        }
+        if (ranges.empty()) {
+            return Result::Unsatisfiable;
+        }
+
+        // Coalesce so a client cannot make the server send the same bytes many times over
+        if (ranges.size() > 1) {
+            std::sort(ranges.begin(), ranges.end(), [](const ByteRange& a, const ByteRange& b) {
+                return a.offset < b.offset;
+            });
+            std::size_t merged = 0;
+            for (std::size_t i = 1; i < ranges.size(); ++i) {
+                ByteRange& current = ranges[merged];
+                if (ranges[i].offset <= current.offset + current.length) {
+                    current.length = std::max(current.offset + current.length, ranges[i].offset + ranges[i].length) - current.offset;
+                } else {
+                    ranges[++merged] = ranges[i];
+                }
+            }
+            ranges.resize(merged + 1);
+        }
+        if (ranges.size() > maxRanges) {
+            ranges.clear();
+            return Result::Ignore;
+        }
+        return Result::Satisfiable;
+    }
+
+} // namespace Network
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef HTTPRANGE_H
+#define HTTPRANGE_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace Network {
+
+// Resolved byte range of a representation
+struct ByteRange {
+    std::uint64_t offset = 0;
+    std::uint64_t length = 0;
+};
+
+// Range header handling (RFC 7233), bytes unit only
+class HttpRange {
+public:
+    enum class Result {
+        Ignore,         // Absent, malformed or too fragmented, send the full representation
+        Satisfiable,    // ranges holds at least one range
+        Unsatisfiable   // No range overlaps the representation (416)
+    };
+
+    // Upper bound on ranges after coalescing, more are answered with the full representation
+    static constexpr std::size_t maxRanges = 16;
+
+    // Resolve a Range header value against a representation of the given size,
+    // overlapping and adjacent ranges are merged
+    static Result parse(std::string_view value, std::uint64_t size, std::vector<ByteRange>& ranges);
+};
+
+} // namespace Network
+
+#endif // HTTPRANGE_H
\ No newline at end of file
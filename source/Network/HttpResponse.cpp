@@ -0,0 +1,94 @@
+#include "HttpResponse.h"
+#include "HttpDate.h"
+#include "../System/Clock.h"
+#include <filesystem>
+
+namespace Network {
+
+    std::optional<FileBody> FileBody::open(const std::string& path) {
+        std::shared_ptr<std::FILE> file(std::fopen(path.c_str(), "rb"), [](std::FILE* handle) {
+            if (handle) std::fclose(handle);
+        });
+        std::error_code ec;
+        std::uint64_t size = std::filesystem::file_size(path, ec);
+        if (!file || ec) {
+            return std::nullopt;
+        }
+        return FileBody{std::move(file), 0, size};
+    }
+
+    void HttpResponse::setError(const std::string& errorStatus, const std::string& errorBody) {
+        status = errorStatus;
+        contentType = "text/html";
+        headers.clear();
+        body = errorBody;
+        file.reset();
+        sharedBody.reset();
+        sharedHeaders.reset();
+        parts.clear();
+        stream.reset();
+        chunked = false;
+        cacheTtl.reset();
+        notModified = false;
+        finish = nullptr;
+        deferred = nullptr;
+    }
+
+    void HttpResponse::setNotModified(const std::string& etag, std::time_t lastModified) {
+        status = "304 Not Modified";
+        headers.clear();
+        headers.emplace_back("ETag", etag);
+        headers.emplace_back("Last-Modified", HttpDate::format(lastModified));
+        body.clear();
+        file.reset();
+        sharedBody.reset();
+        sharedHeaders.reset();
+        parts.clear();
+        notModified = true;
+    }
+
+    std::uint64_t HttpResponse::contentLength() const {
+        if (!parts.empty()) {
+            std::uint64_t length = 0;
+            for (const auto& part : parts) {
+                length += part.header.size() + part.length;
+            }
+            return length;
+        }
+        return file ? file->length : sharedBody ? sharedBody->size() : body.size();
+    }
+
+    std::string HttpResponse::serializeHead() const {
+        std::string result;
+        result.reserve(128);
+        result += "HTTP/1.1 ";
+        result += status;
+        result += "\r\nDate: ";
+        result += System::Clock::now()->httpDate;
+        result += "\r\n";
+        if (sharedHeaders) {
+            result += *sharedHeaders;
+        } else if (stream) {
+            // The length is unknown until the producer is done
+            result += "Content-Type: ";
+            result += contentType;
+            result += chunked ? "\r\nTransfer-Encoding: chunked\r\n" : "\r\n";
+        } else if (!notModified) {
+            result += "Content-Type: ";
+            result += contentType;
+            result += "\r\nContent-Length: ";
+            result += std::to_string(contentLength());
+            result += "\r\n";
+        }
+        result += keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+        for (const auto& [name, value] : headers) {
+            result += name;
+            result += ": ";
+            result += value;
+            result += "\r\n";
+        }
+        result += "\r\n";
+        return result;
+    }
+
+} // namespace Network
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef HTTPRESPONSE_H
+#define HTTPRESPONSE_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "BodyStream.h"
+
+namespace Network {
+
+// Body sent straight from an open file (sendfile on Linux) instead of from memory
+struct FileBody {
+    std::shared_ptr<std::FILE> file;
+    std::uint64_t offset = 0;
+    std::uint64_t length = 0;
+
+    // Open a file for sending, empty if it cannot be opened
+    static std::optional<FileBody> open(const std::string& path);
+};
+
+// Slice of the body source (file, shared or in-memory body) preceded by a multipart header
+struct BodyPart {
+    std::string header; // Part delimiter and headers, empty for a single range
+    std::uint64_t offset = 0;
+    std::uint64_t length = 0;
+};
+
+// HTTP response under construction, serialized once the handler is done with it
+struct HttpResponse {
+    std::string status = "200 OK";
+    std::string contentType = "text/html";
+    std::vector<std::pair<std::string, std::string>> headers; // Additional header fields
+    std::string body;
+    std::optional<FileBody> file; // Replaces body when set
+    std::shared_ptr<const std::string> sharedBody; // Body owned by the file cache, replaces body when set
+    std::shared_ptr<const std::string> sharedHeaders; // Pre-built Content-Type/Content-Length lines from the file cache
+    std::vector<BodyPart> parts; // Send only these slices of the body source (206), whole source when empty
+    std::shared_ptr<BodyStream> stream; // Body produced while sending (script output), replaces body when set
+    bool chunked = false; // Send stream with chunked transfer coding, else it ends with the connection
+    std::optional<std::chrono::seconds> cacheTtl; // Lifetime in a server-side cache from the script's Cache-Control, 0 for never
+    bool keepAlive = false; // Keep the connection open after this response
+    bool notModified = false; // 304 response, sent without body or content headers
+    std::function<void(HttpResponse&)> finish; // Work left for a background thread (compression) before sending
+
+    // Produces the actual response later (e.g. from a FastCGI worker), the completion may run on any thread
+    using Completion = std::function<void(HttpResponse&&)>;
+    std::function<void(Completion)> deferred;
+
+    // Replace status and body, used for error pages
+    void setError(const std::string& errorStatus, const std::string& errorBody);
+
+    // Turn into a 304 Not Modified carrying only the validators
+    void setNotModified(const std::string& etag, std::time_t lastModified);
+
+    // Length of the body, from memory or file
+    std::uint64_t contentLength() const;
+
+    // Render status line and header block including the terminating empty line
+    std::string serializeHead() const;
+};
+
+} // namespace Network
+
+#endif // HTTPRESPONSE_H
\ No newline at end of file
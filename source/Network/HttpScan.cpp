@@ -0,0 +1,198 @@
+#include "HttpScan.h"
+#include <array>
+#include <atomic>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define HTTPSCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace Network {
+
+    namespace {
+        // tchar from RFC 7230
+        constexpr bool isTokenChar(unsigned char c) {
+            if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) return true;
+            switch (c) {
+                case '!': case '#': case '$': case '%': case '&': case '\'': case '*': case '+':
+                case '-': case '.': case '^': case '_': case '`': case '|': case '~':
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        // Control characters other than HT end a line
+        constexpr bool isLineEndChar(unsigned char c) {
+            return (c < 0x20 && c != '\t') || c == 0x7f;
+        }
+
+        constexpr std::array<bool, 256> tokenTable = [] {
+            std::array<bool, 256> table{};
+            for (int c = 0; c < 256; ++c) table[c] = isTokenChar(static_cast<unsigned char>(c));
+            return table;
+        }();
+
+        std::size_t findTokenEndScalar(const char* data, std::size_t size) {
+            std::size_t i = 0;
+            while (i < size && tokenTable[static_cast<unsigned char>(data[i])]) ++i;
+            return i;
+        }
+
+        std::size_t findLineEndScalar(const char* data, std::size_t size) {
+            std::size_t i = 0;
+            while (i < size && !isLineEndChar(static_cast<unsigned char>(data[i]))) ++i;
+            return i;
+        }
+
+#ifdef HTTPSCAN_X86
+        // SSE4.2: PCMPESTRI range matching as in picohttpparser
+
+        __attribute__((target("sse4.2")))
+        std::size_t findTokenEndSse42(const char* data, std::size_t size) {
+            // Byte ranges that end a token. "{\xff" also covers '|' and '~', those hits are re-checked.
+            alignas(16) static const char ranges[16] = {
+                    '\x00', ' ', '"', '"', '(', ')', ',', ',', '/', '/', ':', '@', '[', ']', '{', '\xff'};
+            const __m128i rangeVector = _mm_load_si128(reinterpret_cast<const __m128i*>(ranges));
+            std::size_t i = 0;
+            while (i + 16 <= size) {
+                __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                int index = _mm_cmpestri(rangeVector, 16, block, 16,
+                                         _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT);
+                if (index == 16) {
+                    i += 16;
+                    continue;
+                }
+                i += index;
+                if (!tokenTable[static_cast<unsigned char>(data[i])]) return i;
+                ++i;
+            }
+            return i + findTokenEndScalar(data + i, size - i);
+        }
+
+        __attribute__((target("sse4.2")))
+        std::size_t findLineEndSse42(const char* data, std::size_t size) {
+            alignas(16) static const char ranges[16] = {'\x00', '\x08', '\x0a', '\x1f', '\x7f', '\x7f'};
+            const __m128i rangeVector = _mm_load_si128(reinterpret_cast<const __m128i*>(ranges));
+            std::size_t i = 0;
+            while (i + 16 <= size) {
+                __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                int index = _mm_cmpestri(rangeVector, 6, block, 16,
+                                         _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT);
+                if (index != 16) return i + index;
+                i += 16;
+            }
+            return i + findLineEndScalar(data + i, size - i);
+        }
+
+        // AVX2: exact tchar classification via nibble lookup. For low nibble l, tokenRows[l]
+        // has bit h set when byte (h << 4 | l) is a tchar; bytes >= 0x80 never match.
+        alignas(32) constexpr std::array<unsigned char, 32> tokenRows = [] {
+            std::array<unsigned char, 32> rows{};
+            for (int low = 0; low < 16; ++low) {
+                unsigned char bits = 0;
+                for (int high = 0; high < 8; ++high) {
+                    if (isTokenChar(static_cast<unsigned char>(high << 4 | low))) bits |= static_cast<unsigned char>(1 << high);
+                }
+                rows[low] = rows[low + 16] = bits;
+            }
+            return rows;
+        }();
+
+        alignas(32) constexpr std::array<unsigned char, 32> highBits = {
+                1, 2, 4, 8, 16, 32, 64, 128, 0, 0, 0, 0, 0, 0, 0, 0,
+                1, 2, 4, 8, 16, 32, 64, 128, 0, 0, 0, 0, 0, 0, 0, 0};
+
+        __attribute__((target("avx2,bmi")))
+        std::size_t findTokenEndAvx2(const char* data, std::size_t size) {
+            const __m256i rows = _mm256_load_si256(reinterpret_cast<const __m256i*>(tokenRows.data()));
+            const __m256i bits = _mm256_load_si256(reinterpret_cast<const __m256i*>(highBits.data()));
+            const __m256i nibble = _mm256_set1_epi8(0x0f);
+            const __m256i zero = _mm256_setzero_si256();
+            std::size_t i = 0;
+            while (i + 32 <= size) {
+                __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                __m256i row = _mm256_shuffle_epi8(rows, _mm256_and_si256(block, nibble));
+                __m256i bit = _mm256_shuffle_epi8(bits, _mm256_and_si256(_mm256_srli_epi16(block, 4), nibble));
+                __m256i notToken = _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), zero);
+                unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(notToken));
+                if (mask != 0) return i + _tzcnt_u32(mask);
+                i += 32;
+            }
+            return i + findTokenEndScalar(data + i, size - i);
+        }
+
+        __attribute__((target("avx2,bmi")))
+        std::size_t findLineEndAvx2(const char* data, std::size_t size) {
+            const __m256i control = _mm256_set1_epi8(0x1f);
+            const __m256i tab = _mm256_set1_epi8('\t');
+            const __m256i del = _mm256_set1_epi8(0x7f);
+            std::size_t i = 0;
+            while (i + 32 <= size) {
+                __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                __m256i isControl = _mm256_cmpeq_epi8(_mm256_min_epu8(block, control), block);
+                __m256i isEnd = _mm256_or_si256(_mm256_andnot_si256(_mm256_cmpeq_epi8(block, tab), isControl),
+                                                _mm256_cmpeq_epi8(block, del));
+                unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(isEnd));
+                if (mask != 0) return i + _tzcnt_u32(mask);
+                i += 32;
+            }
+            return i + findLineEndScalar(data + i, size - i);
+        }
+#endif
+
+        struct Kernels {
+            HttpScan::Implementation implementation;
+            std::size_t (*findTokenEnd)(const char*, std::size_t);
+            std::size_t (*findLineEnd)(const char*, std::size_t);
+        };
+
+        constexpr Kernels scalarKernels{HttpScan::Implementation::Scalar, findTokenEndScalar, findLineEndScalar};
+#ifdef HTTPSCAN_X86
+        constexpr Kernels sse42Kernels{HttpScan::Implementation::SSE42, findTokenEndSse42, findLineEndSse42};
+        constexpr Kernels avx2Kernels{HttpScan::Implementation::AVX2, findTokenEndAvx2, findLineEndAvx2};
+#endif
+
+        const Kernels* bestKernels(HttpScan::Implementation limit) {
+#ifdef HTTPSCAN_X86
+            __builtin_cpu_init();
+            if (limit >= HttpScan::Implementation::AVX2 && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi")) {
+                return &avx2Kernels;
+            }
+            if (limit >= HttpScan::Implementation::SSE42 && __builtin_cpu_supports("sse4.2")) {
+                return &sse42Kernels;
+            }
+#else
+            (void)limit;
+#endif
+            return &scalarKernels;
+        }
+
+        std::atomic<const Kernels*> activeKernels{bestKernels(HttpScan::Implementation::AVX2)};
+    }
+
+    std::size_t HttpScan::findTokenEnd(const char* data, std::size_t size) {
+        return activeKernels.load(std::memory_order_relaxed)->findTokenEnd(data, size);
+    }
+
+    std::size_t HttpScan::findLineEnd(const char* data, std::size_t size) {
+        return activeKernels.load(std::memory_order_relaxed)->findLineEnd(data, size);
+    }
+
+    HttpScan::Implementation HttpScan::implementation() {
+        return activeKernels.load(std::memory_order_relaxed)->implementation;
+    }
+
+    void HttpScan::setImplementation(Implementation implementation) {
+        activeKernels.store(bestKernels(implementation), std::memory_order_relaxed);
+    }
+
+    const char* HttpScan::name(Implementation implementation) {
+        switch (implementation) {
+            case Implementation::SSE42: return "SSE4.2";
+            case Implementation::AVX2: return "AVX2";
+            default: return "scalar";
+        }
+    }
+
+} // namespace Network
\ No newline at end of file
@@ -0,0 +1,33 @@
+#ifndef HTTPSCAN_H
+#define HTTPSCAN_H
+
+#include <cstddef>
+
+namespace Network {
+
+// Character class scanning for the HTTP parser. SSE4.2 and AVX2 kernels are selected
+// at runtime from the CPU features, the scalar versions are used everywhere else.
+class HttpScan {
+public:
+    enum class Implementation { Scalar, SSE42, AVX2 };
+
+    // Offset of the first byte that is not a tchar (RFC 7230), size if there is none.
+    // Ends methods at SP and header names at ':'.
+    static std::size_t findTokenEnd(const char* data, std::size_t size);
+
+    // Offset of the first control character other than HT, size if there is none.
+    // Ends header values and request targets at CR/LF and stops on stray control bytes.
+    static std::size_t findLineEnd(const char* data, std::size_t size);
+
+    // Kernels in use, the best one supported by the CPU unless overridden
+    static Implementation implementation();
+
+    // Force a kernel (e.g. for benchmarks), falls back to the best supported one
+    static void setImplementation(Implementation implementation);
+
+    static const char* name(Implementation implementation);
+};
+
+} // namespace Network
+
+#endif // HTTPSCAN_H
\ No newline at end of file
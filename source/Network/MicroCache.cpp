@@ -0,0 +1,424 @@
+#include "MicroCache.h"
+#include <boost/asio/error.hpp>
+#include <algorithm>
+#include <bit>
+#include <cctype>
+
+namespace Network {
+
+    namespace {
+        // Hands a body to the client unchanged and completes the fill with it at its end
+        class CaptureBodyStream : public BodyStream, public std::enable_shared_from_this<CaptureBodyStream> {
+        public:
+            CaptureBodyStream(std::shared_ptr<BodyStream> source, std::shared_ptr<MicroCache::Fill> fill)
+                    : source_(std::move(source)), fill_(std::move(fill)) {
+            }
+
+            void read(ReadHandler handler) override {
+                source_->read([self = shared_from_this(), handler = std::move(handler)](const boost::system::error_code& error,
+                                                                                       std::string_view data) {
+                    if (self->fill_) {
+                        bool last = error == boost::asio::error::eof;
+                        if (error && !last) {
+                            self->fill_->abandon();
+                            self->fill_.reset();
+                        } else if (self->body_.size() + data.size() > self->fill_->getMaxSize()) {
+                            self->fill_->abandon(true);
+                            self->fill_.reset();
+                            self->body_ = std::string();
+                        } else {
+                            self->body_.append(data);
+                            if (last) {
+                                self->fill_->complete(std::move(self->body_));
+                                self->fill_.reset();
+                            }
+                        }
+                    }
+                    handler(error, data);
+                });
+            }
+
+        private:
+            std::shared_ptr<BodyStream> source_;
+            std::shared_ptr<MicroCache::Fill> fill_; // Reset once completed
+            std::string body_;
+        };
+
+        bool isUnreserved(char c) {
+            return std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '.' || c == '_' || c == '~';
+        }
+
+        int hexValue(char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        // Decode escaped unreserved characters and write the remaining escapes in upper case (RFC 3986 6.2.2)
+        void appendNormalizedEscapes(std::string& out, std::string_view data) {
+            for (std::size_t i = 0; i < data.size(); ++i) {
+                int high = -1, low = -1;
+                if (data[i] == '%' && i + 2 < data.size()) {
+                    high = hexValue(data[i + 1]);
+                    low = hexValue(data[i + 2]);
+                }
+                if (high < 0 || low < 0) {
+                    out += data[i];
+                    continue;
+                }
+                char decoded = static_cast<char>(high * 16 + low);
+                if (isUnreserved(decoded)) {
+                    out += decoded;
+                } else {
+                    out += '%';
+                    out += static_cast<char>(std::toupper(static_cast<unsigned char>(data[i + 1])));
+                    out += static_cast<char>(std::toupper(static_cast<unsigned char>(data[i + 2])));
+                }
+                i += 2;
+            }
+        }
+
+        // Status codes cacheable by default (RFC 7231 6.1) that carry a body
+        bool isCacheableStatus(std::string_view status) {
+            std::string_view code = status.substr(0, 3);
+            return code == "200" || code == "203" || code == "300" || code == "301" || code == "404" || code == "410";
+        }
+    }
+
+    MicroCache::Fill::Fill(std::shared_ptr<MicroCache> cache, std::string key, const System::HtaccessConfig& config,
+                           std::uint64_t generation)
+            : cache_(std::move(cache)), key_(std::move(key)), ttl_(config.microCache), stale_(config.microCacheStale),
+              vary_(config.microCacheVary), generation_(generation), maxSize_(cache_->maxEntrySize_) {
+    }
+
+    MicroCache::Fill::~Fill() {
+        abandon();
+    }
+
+    bool MicroCache::Fill::accept(const HttpResponse& response) {
+        bool cacheable = isCacheableStatus(response.status) && !response.notModified && !response.file
+                         && (!response.cacheTtl || response.cacheTtl->count() > 0);
+        for (const auto& [name, value] : response.headers) {
+            if (!cacheable) {
+                break;
+            }
+            if (equalsIgnoreCase(name, "Set-Cookie") || equalsIgnoreCase(name, "Content-Encoding")) {
+                cacheable = false;
+            } else if (equalsIgnoreCase(name, "Vary")) {
+                // Only what the key covers, Accept-Encoding is negotiated for every hit
+                std::string_view fields(value);
+                while (cacheable && !fields.empty()) {
+                    std::size_t comma = fields.find(',');
+                    std::string_view field = fields.substr(0, comma);
+                    fields.remove_prefix(comma == std::string_view::npos ? fields.size() : comma + 1);
+                    while (!field.empty() && field.front() == ' ') field.remove_prefix(1);
+                    while (!field.empty() && field.back() == ' ') field.remove_suffix(1);
+                    cacheable = field.empty() || equalsIgnoreCase(field, "Accept-Encoding")
+                                || std::any_of(vary_.begin(), vary_.end(), [&](const std::string& header) {
+                                       return equalsIgnoreCase(field, header);
+                                   });
+                }
+            }
+        }
+        if (!cacheable) {
+            abandon(true);
+            return false;
+        }
+        auto entry = std::make_shared<Entry>();
+        entry->key = key_;
+        entry->status = response.status;
+        entry->contentType = response.contentType;
+        entry->headers = response.headers;
+        if (response.cacheTtl) {
+            ttl_ = std::min(ttl_, *response.cacheTtl); // The script may shorten the lifetime, not extend it
+        }
+        entry_ = std::move(entry);
+        return true;
+    }
+
+    std::shared_ptr<BodyStream> MicroCache::Fill::capture(const HttpResponse& response, std::shared_ptr<BodyStream> body) {
+        if (done_ || !accept(response)) {
+            return body;
+        }
+        return std::make_shared<CaptureBodyStream>(std::move(body), shared_from_this());
+    }
+
+    void MicroCache::Fill::store(const HttpResponse& response) {
+        if (done_ || !accept(response)) {
+            return;
+        }
+        complete(response.sharedBody ? *response.sharedBody : response.body);
+    }
+
+    void MicroCache::Fill::complete(std::string body) {
+        if (!entry_ || body.size() > maxSize_) {
+            abandon(entry_ != nullptr);
+            return;
+        }
+        if (done_.exchange(true)) {
+            return;
+        }
+        entry_->body = std::make_shared<const std::string>(std::move(body));
+        entry_->expires = Clock::now() + ttl_;
+        entry_->staleUntil = entry_->expires + stale_;
+        cache_->finish(key_, generation_, std::move(entry_), false, ttl_);
+    }
+
+    void MicroCache::Fill::abandon(bool pass) {
+        if (done_.exchange(true)) {
+            return;
+        }
+        cache_->finish(key_, generation_, nullptr, pass, ttl_);
+    }
+
+    MicroCache::MicroCache(std::size_t byteBudget, std::size_t maxEntrySize)
+            : byteBudget_(byteBudget), maxEntrySize_(maxEntrySize) {
+    }
+
+    MicroCache::Lookup MicroCache::lookup(const std::string& key, const System::HtaccessConfig& config) {
+        auto now = Clock::now();
+        std::lock_guard<std::mutex> guard(mutex_);
+        auto it = slots_.find(key);
+        if (it == slots_.end()) {
+            it = slots_.emplace(key, Slot()).first;
+        }
+        Slot& slot = it->second;
+        if (slot.entry) {
+            if (now < slot.entry->expires) {
+                lru_.splice(lru_.begin(), lru_, slot.lru);
+                if (!slot.entry->body) {
+                    return {Status::Pass, nullptr, nullptr};
+                }
+                ++hits_;
+                return {Status::Hit, slot.entry, nullptr};
+            }
+            if (slot.entry->body && now < slot.entry->staleUntil) {
+                ++stale_;
+                lru_.splice(lru_.begin(), lru_, slot.lru);
+                if (slot.filling) {
+                    return {Status::Stale, slot.entry, nullptr};
+                }
+                slot.filling = true;
+                return {Status::Stale, slot.entry, std::make_shared<Fill>(shared_from_this(), key, config, generation_)};
+            }
+            dropEntry(slot);
+        }
+        if (slot.filling) {
+            ++coalesced_;
+            return {Status::Busy, nullptr, nullptr};
+        }
+        ++misses_;
+        slot.filling = true;
+        return {Status::Miss, nullptr, std::make_shared<Fill>(shared_from_this(), key, config, generation_)};
+    }
+
+    void MicroCache::wait(const std::string& key, Waiter waiter) {
+        std::shared_ptr<const Entry> entry;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            auto it = slots_.find(key);
+            if (it != slots_.end()) {
+                if (it->second.filling) {
+                    it->second.waiters.push_back(std::move(waiter));
+                    return;
+                }
+                if (it->second.entry && it->second.entry->body && Clock::now() < it->second.entry->staleUntil) {
+                    entry = it->second.entry;
+                }
+            }
+        }
+        waiter(std::move(entry));
+    }
+
+    void MicroCache::finish(const std::string& key, std::uint64_t generation, std::shared_ptr<const Entry> entry, bool pass,
+                            std::chrono::seconds ttl) {
+        std::vector<Waiter> waiters;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            auto it = slots_.find(key);
+            if (it == slots_.end()) {
+                return;
+            }
+            Slot& slot = it->second;
+            slot.filling = false;
+            waiters.swap(slot.waiters);
+
+            std::shared_ptr<const Entry> stored = entry;
+            if (!stored && pass) {
+                auto marker = std::make_shared<Entry>();
+                marker->key = key;
+                marker->expires = marker->staleUntil = Clock::now() + ttl;
+                stored = std::move(marker);
+            }
+            if (stored && generation == generation_) {
+                dropEntry(slot);
+                slot.entry = std::move(stored);
+                lru_.push_front(key);
+                slot.lru = lru_.begin();
+                bytes_ += footprint(*slot.entry);
+                evict();
+            } else if (!slot.entry) {
+                slots_.erase(it); // Nothing to keep, a failed refresh leaves the stale entry in place
+            }
+        }
+        // Outside the lock, waiters may look up the cache again
+        for (auto& waiter : waiters) {
+            waiter(entry);
+        }
+    }
+
+    std::shared_ptr<const std::string> MicroCache::findCompressed(const Entry& entry, unsigned coding, bool& claimed) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        std::size_t slot = std::countr_zero(coding);
+        claimed = false;
+        if (!entry.compressed[slot] && !(entry.compressing & coding)) {
+            entry.compressing |= coding;
+            claimed = true;
+        }
+        return entry.compressed[slot];
+    }
+
+    void MicroCache::storeCompressed(const Entry& entry, unsigned coding, std::shared_ptr<const std::string> body) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        entry.compressing &= ~coding;
+        auto it = slots_.find(entry.key);
+        if (it == slots_.end() || it->second.entry.get() != &entry) {
+            return; // Replaced or evicted while it was compressed
+        }
+        bytes_ -= footprint(entry);
+        entry.compressed[std::countr_zero(coding)] = body ? std::move(body) : entry.body;
+        bytes_ += footprint(entry);
+        evict();
+    }
+
+    void MicroCache::clear() {
+        std::lock_guard<std::mutex> guard(mutex_);
+        ++generation_;
+        for (auto it = slots_.begin(); it != slots_.end();) {
+            dropEntry(it->second);
+            if (it->second.filling) {
+                ++it;
+            } else {
+                it = slots_.erase(it);
+            }
+        }
+    }
+
+    MicroCache::Stats MicroCache::getStats() const {
+        std::lock_guard<std::mutex> guard(mutex_);
+        Stats stats;
+        stats.hits = hits_;
+        stats.misses = misses_;
+        stats.stale = stale_;
+        stats.coalesced = coalesced_;
+        stats.evictions = evictions_;
+        stats.entries = lru_.size();
+        stats.bytes = bytes_;
+        return stats;
+    }
+
+    void MicroCache::dropEntry(Slot& slot) {
+        if (slot.entry) {
+            bytes_ -= footprint(*slot.entry);
+            lru_.erase(slot.lru);
+            slot.entry.reset();
+        }
+    }
+
+    std::size_t MicroCache::footprint(const Entry& entry) {
+        std::size_t bytes = entry.key.size() + (entry.body ? entry.body->size() : 0);
+        for (const auto& body : entry.compressed) {
+            if (body && body != entry.body) bytes += body->size();
+        }
+        return bytes;
+    }
+
+    void MicroCache::evict() {
+        while (bytes_ > byteBudget_ && !lru_.empty()) {
+            auto it = slots_.find(lru_.back());
+            dropEntry(it->second);
+            if (!it->second.filling) {
+                slots_.erase(it);
+            }
+            ++evictions_;
+        }
+    }
+
+    std::string MicroCache::key(const HttpRequest& request, const std::vector<std::string>& vary) {
+        if ((request.method != "GET" && request.method != "HEAD") || request.contentLength > 0
+            || !request.header("Authorization").empty()) {
+            return {};
+        }
+        auto varies = [&](std::string_view name) {
+            return std::any_of(vary.begin(), vary.end(), [&](const std::string& header) { return equalsIgnoreCase(name, header); });
+        };
+        if (!request.header("Cookie").empty() && !varies("Cookie")) {
+            return {};
+        }
+
+        std::string key(request.method);
+        key += ' ';
+        for (char c : request.header("Host")) {
+            key += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        key += normalizeTarget(request.target);
+        for (const auto& name : vary) {
+            key += '\n';
+            key += name;
+            key += ": ";
+            key += request.header(name);
+        }
+        return key;
+    }
+
+    std::string MicroCache::normalizeTarget(std::string_view target) {
+        std::size_t question = target.find('?');
+        std::string_view path = target.substr(0, question);
+        std::string_view query = question == std::string_view::npos ? std::string_view() : target.substr(question + 1);
+
+        std::string decoded;
+        appendNormalizedEscapes(decoded, path);
+        std::vector<std::string_view> segments;
+        std::string_view rest(decoded);
+        while (!rest.empty()) {
+            std::size_t slash = rest.find('/');
+            std::string_view segment = rest.substr(0, slash);
+            rest.remove_prefix(slash == std::string_view::npos ? rest.size() : slash + 1);
+            if (segment == "..") {
+                if (!segments.empty()) segments.pop_back();
+            } else if (!segment.empty() && segment != ".") {
+                segments.push_back(segment);
+            }
+        }
+        std::string result;
+        result.reserve(target.size());
+        for (auto segment : segments) {
+            result += '/';
+            result += segment;
+        }
+        if (result.empty() || decoded.ends_with('/') || decoded.ends_with("/.") || decoded.ends_with("/..")) {
+            result += '/';
+        }
+
+        // Parameters with the same name keep their order, it decides which one a script sees
+        std::vector<std::string> parameters;
+        while (!query.empty()) {
+            std::size_t amp = query.find('&');
+            std::string_view parameter = query.substr(0, amp);
+            query.remove_prefix(amp == std::string_view::npos ? query.size() : amp + 1);
+            if (!parameter.empty()) {
+                appendNormalizedEscapes(parameters.emplace_back(), parameter);
+            }
+        }
+        std::stable_sort(parameters.begin(), parameters.end(), [](const std::string& a, const std::string& b) {
+            return std::string_view(a).substr(0, a.find('=')) < std::string_view(b).substr(0, b.find('='));
+        });
+        for (std::size_t i = 0; i < parameters.size(); ++i) {
+            result += i == 0 ? '?' : '&';
+            result += parameters[i];
+        }
+        return result;
+    }
+
+} // namespace Network
\ No newline at end of file
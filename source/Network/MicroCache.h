@@ -0,0 +1,180 @@
+#ifndef MICROCACHE_H
+#define MICROCACHE_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "BodyStream.h"
+#include "HttpParser.h"
+#include "HttpResponse.h"
+#include "../System/HtaccessConfig.h"
+
+namespace Network {
+
+// Short-lived cache of script responses for one project, enabled with MicroCache in .htaccess.
+// Concurrent misses for the same key are coalesced: one request runs the script and the others
+// wait for its response. Expired entries are still served during the MicroCacheStale grace
+// period while a single request refreshes them.
+class MicroCache : public std::enable_shared_from_this<MicroCache> {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::string key;
+        std::string status;
+        std::string contentType;
+        std::vector<std::pair<std::string, std::string>> headers;
+        std::shared_ptr<const std::string> body; // Null for a pass marker
+        Clock::time_point expires;               // Fresh until then
+        Clock::time_point staleUntil;            // Served while being refreshed until then
+
+        // Bodies compressed on the fly by coding bit, body itself when compression does not pay off.
+        // Guarded by the cache lock
+        mutable std::array<std::shared_ptr<const std::string>, 4> compressed;
+        mutable unsigned compressing = 0; // Codings some request is producing right now
+    };
+
+    struct Stats {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;    // The request ran the script
+        std::uint64_t stale = 0;     // Served after expiry while being refreshed
+        std::uint64_t coalesced = 0; // Waited for another request running the script
+        std::uint64_t evictions = 0;
+        std::size_t entries = 0;
+        std::size_t bytes = 0;
+    };
+
+    // The one script run that produces an entry. Completed exactly once: by the body passing
+    // through capture(), by store(), by abandon(), or on destruction
+    class Fill : public std::enable_shared_from_this<Fill> {
+    public:
+        Fill(std::shared_ptr<MicroCache> cache, std::string key, const System::HtaccessConfig& config, std::uint64_t generation);
+
+        // Gives up if the response never completed, the waiters then run the script themselves
+        ~Fill();
+
+        // Body to send for a response whose head is complete: a stream storing what passes through
+        // it, or body unchanged when the response is not cacheable
+        std::shared_ptr<BodyStream> capture(const HttpResponse& response, std::shared_ptr<BodyStream> body);
+
+        // Store a response with its body in memory
+        void store(const HttpResponse& response);
+
+        // No entry comes of this run. pass keeps requests for the key from waiting on each other
+        // for the TTL, for responses that are not cacheable
+        void abandon(bool pass = false);
+
+        // Store the body completing the head taken by capture()
+        void complete(std::string body);
+
+        std::size_t getMaxSize() const { return maxSize_; }
+
+    private:
+        // Take the head when the response may be cached, else abandon with pass
+        bool accept(const HttpResponse& response);
+
+        std::shared_ptr<MicroCache> cache_;
+        std::string key_;
+        std::chrono::seconds ttl_;
+        std::chrono::seconds stale_;
+        std::vector<std::string> vary_;
+        std::uint64_t generation_;
+        std::size_t maxSize_;
+        std::shared_ptr<Entry> entry_; // Head taken by accept()
+        std::atomic<bool> done_ = false;
+    };
+
+    enum class Status {
+        Hit,   // entry is fresh
+        Stale, // entry expired within the grace period, fill is set for the one request refreshing it
+        Miss,  // Run the script and complete fill
+        Busy,  // Another request runs the script, wait() for it
+        Pass   // Recently found not cacheable, run the script without the cache
+    };
+
+    struct Lookup {
+        Status status = Status::Miss;
+        std::shared_ptr<const Entry> entry;
+        std::shared_ptr<Fill> fill;
+    };
+
+    // Called with the produced entry, or null when there is none and the script has to run again
+    using Waiter = std::function<void(std::shared_ptr<const Entry> entry)>;
+
+    explicit MicroCache(std::size_t byteBudget = 16 * 1024 * 1024, std::size_t maxEntrySize = 1024 * 1024);
+
+    // Look up a key, starting a fill for a miss or an expired entry. Counts the outcome
+    Lookup lookup(const std::string& key, const System::HtaccessConfig& config);
+
+    // Wait for the run that made lookup() return Busy, waiter runs at once if it already finished
+    void wait(const std::string& key, Waiter waiter);
+
+    // Compressed body of an entry. When there is none yet and nobody is producing it, claimed is
+    // set and the caller is expected to call storeCompressed()
+    std::shared_ptr<const std::string> findCompressed(const Entry& entry, unsigned coding, bool& claimed);
+
+    // Attach a compressed body, null records that compression does not pay off
+    void storeCompressed(const Entry& entry, unsigned coding, std::shared_ptr<const std::string> body);
+
+    // Drop every entry, runs in progress finish but are not stored
+    void clear();
+
+    Stats getStats() const;
+
+    // Cache key of a request: method, host, normalized target and the values of the vary headers.
+    // Empty when the request must not be cached: not GET or HEAD, a body, Authorization, or a
+    // Cookie that is not one of the vary headers
+    static std::string key(const HttpRequest& request, const std::vector<std::string>& vary);
+
+    // Target with duplicate slashes and dot segments removed, escaped unreserved characters
+    // decoded and query parameters ordered by name
+    static std::string normalizeTarget(std::string_view target);
+
+private:
+    struct Slot {
+        std::shared_ptr<const Entry> entry;
+        std::list<std::string>::iterator lru; // Valid while entry is set
+        bool filling = false;
+        std::vector<Waiter> waiters;
+    };
+
+    // Finish the run of a key, storing entry (a pass marker when null and pass) and waking the waiters
+    void finish(const std::string& key, std::uint64_t generation, std::shared_ptr<const Entry> entry, bool pass,
+                std::chrono::seconds ttl);
+
+    // Remove the entry of a slot, under the lock
+    void dropEntry(Slot& slot);
+
+    // Bytes held by an entry including its compressed bodies, under the lock
+    static std::size_t footprint(const Entry& entry);
+
+    // Evict least recently used entries until the budget is met, under the lock
+    void evict();
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Slot> slots_;
+    std::list<std::string> lru_; // Keys with an entry, most recently used first
+    std::size_t bytes_ = 0;
+    std::size_t byteBudget_;
+    std::size_t maxEntrySize_;
+    std::uint64_t generation_ = 0; // Bumped by clear(), fills started before are not stored
+    std::uint64_t hits_ = 0;
+    std::uint64_t misses_ = 0;
+    std::uint64_t stale_ = 0;
+    std::uint64_t coalesced_ = 0;
+    std::uint64_t evictions_ = 0;
+};
+
+} // namespace Network
+
+#endif // MICROCACHE_H
\ No newline at end of file
@@ -1,127 +1,598 @@
 #include "RequestHandler.h"
+#include "CgiProcess.h"
+#include "CgiResponse.h"
+#include "Connection.h"
+#include "ContentEncoding.h"
+#include "FastCgi.h"
+#include "FastCgiRequest.h"
+#include "HttpDate.h"
+#include "HttpRange.h"
 #include "../System/HtaccessConfig.h"
 #include "../Debug/Log.h"
-#include <fstream>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
 #include <sstream>
 #include <filesystem>
-#include <cstdlib>
+#include <random>
 #include <stdio.h> // For popen/pclose
 
 namespace Network {
 
-    RequestHandler::RequestHandler(boost::asio::io_context& ioContext, const std::string& rootDir)
-            : ioContext_(ioContext), rootDir_(rootDir) {
+    namespace {
+        constexpr std::size_t sharedOutputLimit = 8 * 1024 * 1024; // Output held for a slow client on a shared php-fpm connection
+    }
+
+    RequestHandler::RequestHandler(boost::asio::io_context& ioContext, const std::string& rootDir,
+                                   std::shared_ptr<System::FileCache> fileCache, std::shared_ptr<Compressor> compressor,
+                                   std::shared_ptr<FastCgiClient> fastCgiClient, std::shared_ptr<System::PhpInterpreter> php)
+            : ioContext_(ioContext), rootDir_(rootDir), fileCache_(std::move(fileCache)), compressor_(std::move(compressor)),
+              fastCgiClient_(std::move(fastCgiClient)), php_(php ? std::move(php) : std::make_shared<System::PhpInterpreter>()),
+              microCache_(std::make_shared<MicroCache>()) {
+        reloadConfig();
+    }
+
+    void RequestHandler::reloadConfig() {
         // Parse .htaccess for MIME types
-        htaccessConfig_ = System::HtaccessConfig::parse((std::filesystem::path(rootDir_) / ".htaccess").string());
+        htaccessConfig_.store(std::make_shared<const System::HtaccessConfig>(
+                System::HtaccessConfig::parse((std::filesystem::path(rootDir_) / ".htaccess").string())));
     }
 
-    void RequestHandler::handleRequest(std::shared_ptr<boost::asio::ip::tcp::socket> socket) {
-        Debug::Log::info("Handling new request", "RequestHandler");
-        try {
-            boost::asio::streambuf request;
-            boost::system::error_code error;
-            boost::asio::read_until(*socket, request, "\r\n\r\n", error);
+    void RequestHandler::onFileChanged(const std::filesystem::path& path, bool subtree) {
+        // Scripts may read any file of the project, cached responses are not tracked per file
+        microCache_->clear();
+        // Compared in normal form, the project path may end in a separator ("domains/site/")
+        bool config = path.lexically_normal() == (std::filesystem::path(rootDir_) / ".htaccess").lexically_normal();
+        if (config) {
+            Debug::Log::info(std::format("Reloading {}", path.string()), "RequestHandler");
+            reloadConfig();
+        }
+        if (!fileCache_) {
+            return;
+        }
+        if (config) {
+            // MIME types are baked into cached headers, drop the whole project
+            fileCache_->invalidatePrefix(std::filesystem::path(rootDir_).lexically_normal().string());
+        } else if (subtree) {
+            fileCache_->invalidatePrefix(path.lexically_normal().string());
+        } else {
+            fileCache_->invalidate(path.lexically_normal().string());
+        }
+    }
 
-            if (error && error != boost::asio::error::eof) {
-                Debug::Log::error(std::format("Error reading request: {}", error.message()), "RequestHandler");
-                return;
-            }
+    void RequestHandler::handleRequest(std::shared_ptr<boost::asio::ip::tcp::socket> socket, std::function<void()> onClose,
+                                       std::function<void()> onRequest) {
+        LOG_DEBUG("RequestHandler", "Handling new request");
+        std::make_shared<Connection>(std::move(socket), shared_from_this(), std::move(onClose), std::move(onRequest))->start();
+    }
 
-            std::stringstream requestStream;
-            requestStream << &request;
+    HttpResponse RequestHandler::processRequest(const HttpRequest& request, bool allowKeepAlive,
+                                                const boost::asio::any_io_executor& executor) {
+        LOG_DEBUG("RequestHandler", "Received {} request for {}", request.method, request.target);
 
-            std::string requestLine;
-            std::getline(requestStream, requestLine);
-            Debug::Log::info(std::format("Received {} request for {}",
-                                         requestLine.substr(0, requestLine.find(' ')),
-                                         requestLine.substr(requestLine.find(' ') + 1,
-                                                            requestLine.find(' ', requestLine.find(' ') + 1) - requestLine.find(' ') - 1)),
-                             "RequestHandler");
+        std::string path(request.path());
+        if (path == "/") path = "/index.html";
 
-            std::string path = requestLine.substr(requestLine.find(' ') + 1,
-                                                  requestLine.find(' ', requestLine.find(' ') + 1) - requestLine.find(' ') - 1);
-            if (path == "/") path = "/index.html";
+        auto config = getConfig();
+        HttpResponse response;
+        response.keepAlive = allowKeepAlive && config->keepAlive && request.keepAlive();
+        std::filesystem::path filePath = (std::filesystem::path(rootDir_) / path.substr(1)).lexically_normal();
 
-            std::stringstream responseStream;
-            std::string contentType = "text/html"; // Default MIME type
-            std::filesystem::path filePath = std::filesystem::path(rootDir_) / path.substr(1);
+        // Check MIME type from .htaccess
+        std::string extension = filePath.extension().string();
+        if (auto it = config->mimeTypes.find(extension); !extension.empty() && it != config->mimeTypes.end()) {
+            response.contentType = it->second;
+            LOG_DEBUG("RequestHandler", "Using MIME type {} for extension {}", response.contentType, extension);
+        }
 
-            // Check MIME type from .htaccess
-            std::string extension = filePath.extension().string();
-            if (!extension.empty() && htaccessConfig_.mimeTypes.count(extension)) {
-                contentType = htaccessConfig_.mimeTypes[extension];
-                Debug::Log::info(std::format("Using MIME type {} for extension {}", contentType, extension), "RequestHandler");
+        // Cached static files are answered without touching the filesystem
+        Variant variant{filePath.string()};
+        if (fileCache_ && extension != ".php") {
+            variant = selectVariant(filePath.string(), request, *config, response.contentType);
+            if (auto entry = fileCache_->find(variant.path)) {
+                sendCachedFile(entry, variant, request, *config, response);
+                LOG_DEBUG("RequestHandler", "Served cached file: {}", entry->path);
+                return response;
             }
+        }
 
-            responseStream << "HTTP/1.1 200 OK\r\nContent-Type: " << contentType << "\r\nConnection: close\r\n\r\n";
-
+        if (!std::filesystem::exists(filePath)) {
+            filePath = std::filesystem::path(rootDir_) / "index.php";
             if (!std::filesystem::exists(filePath)) {
-                filePath = std::filesystem::path(rootDir_) / "index.php";
-                if (!std::filesystem::exists(filePath)) {
-                    responseStream.str("HTTP/1.1 404 Not Found\r\nContent-Type: text/html\r\nConnection: close\r\n\r\n<h1>404 Not Found</h1>");
-                    Debug::Log::error(std::format("File not found: {}", filePath.string()), "RequestHandler");
-                }
+                response.setError("404 Not Found", "<h1>404 Not Found</h1>");
+                Debug::Log::error(std::format("File not found: {}", filePath.string()), "RequestHandler");
+            }
 
-            } else if (filePath.extension() == ".php") {
-                handlePhpRequest(filePath.string(), requestStream, responseStream);
+        } else if (filePath.extension() == ".php") {
+            if (config->microCache > 0) {
+                handleCachedPhpRequest(filePath.string(), request, executor, config, response);
             } else {
-                serveStaticFile(filePath.string(), responseStream);
+                runPhpScript(filePath.string(), request, executor, config, nullptr, response);
+            }
+        } else {
+            serveStaticFile(variant, request, *config, response);
+        }
+
+        return response;
+    }
+
+    void RequestHandler::finishResponse(HttpResponse&& response, std::function<void(HttpResponse&&)> done) {
+        auto work = [response = std::move(response), done = std::move(done)]() mutable {
+            auto finish = std::move(response.finish);
+            response.finish = nullptr;
+            try {
+                finish(response);
+            } catch (const std::exception& e) {
+                Debug::Log::error(std::format("Error finishing response: {}", e.what()), "RequestHandler");
+                response.setError("500 Internal Server Error", "<h1>500 Internal Server Error</h1>");
             }
+            done(std::move(response));
+        };
+        if (compressor_) {
+            compressor_->post(std::move(work));
+        } else {
+            work();
+        }
+    }
 
-            boost::asio::write(*socket, boost::asio::buffer(responseStream.str()), error);
-            if (error) {
-                Debug::Log::error(std::format("Error writing response: {}", error.message()), "RequestHandler");
+    RequestHandler::Variant RequestHandler::selectVariant(const std::string& path, const HttpRequest& request,
+                                                          const System::HtaccessConfig& config, const std::string& contentType) {
+        Variant variant{path};
+        unsigned accepted = ContentEncoding::accepted(request.header("Accept-Encoding"));
+        if (unsigned available = fileCache_->precompressed(path)) {
+            variant.vary = true;
+            variant.coding = ContentEncoding::select(available & accepted);
+            if (variant.coding != ContentEncoding::Identity) {
+                variant.path += ContentEncoding::sidecarExtension(variant.coding);
+                return variant;
             }
-        } catch (const std::exception& e) {
-            Debug::Log::error(std::format("Error handling request: {}", e.what()), "RequestHandler");
         }
+        // Without a matching sidecar the cached body is compressed on the fly
+        if (compressor_ && config.compression && config.isCompressible(contentType)) {
+            variant.vary = true;
+            variant.coding = ContentEncoding::select(accepted & Compressor::available());
+            variant.dynamic = variant.coding != ContentEncoding::Identity;
+        }
+        return variant;
     }
 
-    void RequestHandler::serveStaticFile(const std::string& path, std::stringstream& responseStream) {
-        std::ifstream file(path, std::ios::binary);
-        if (file) {
-            std::stringstream content;
-            content << file.rdbuf();
-            responseStream << content.str();
-            Debug::Log::info(std::format("Served static file: {}", path), "RequestHandler");
+    void RequestHandler::serveStaticFile(const Variant& variant, const HttpRequest& request, const System::HtaccessConfig& config,
+                                         HttpResponse& response) {
+        const std::string& path = variant.path;
+
+        // Small files are kept in the cache for the next request
+        if (fileCache_) {
+            std::string extraHeaders;
+            if (variant.coding != ContentEncoding::Identity && !variant.dynamic) {
+                extraHeaders += std::format("Content-Encoding: {}\r\n", ContentEncoding::name(variant.coding));
+            }
+            if (variant.vary) {
+                extraHeaders += "Vary: Accept-Encoding\r\n";
+            }
+            if (auto entry = fileCache_->load(path, response.contentType, extraHeaders)) {
+                sendCachedFile(entry, variant, request, config, response);
+                LOG_DEBUG("RequestHandler", "Served static file: {}", path);
+                return;
+            }
+        }
+
+        // Large files are not read here, the connection streams them from the open file.
+        // They are never compressed on the fly, that would give up sendfile
+        Variant sent = variant;
+        if (sent.dynamic) {
+            sent.coding = ContentEncoding::Identity;
+            sent.dynamic = false;
+        }
+        std::error_code ec;
+        auto modified = std::filesystem::last_write_time(path, ec);
+        response.file = FileBody::open(path);
+        if (response.file) {
+            if (!ec) {
+                std::string etag = System::FileCache::entityTag(response.file->length, modified);
+                std::time_t lastModified = HttpDate::fromFileTime(modified);
+                if (checkNotModified(request, etag, lastModified, response)) {
+                    addVariantHeaders(sent, response);
+                    LOG_DEBUG("RequestHandler", "Not modified: {}", path);
+                    return;
+                }
+                if (!applyRange(request, etag, lastModified, response.file->length, response)) {
+                    response.headers.emplace_back("Accept-Ranges", "bytes");
+                    response.headers.emplace_back("ETag", etag);
+                    response.headers.emplace_back("Last-Modified", HttpDate::format(lastModified));
+                }
+            }
+            addVariantHeaders(sent, response);
+            LOG_DEBUG("RequestHandler", "Served static file: {}", path);
         } else {
-            responseStream.str("HTTP/1.1 404 Not Found\r\nContent-Type: text/html\r\nConnection: close\r\n\r\n<h1>404 Not Found</h1>");
+            response.setError("404 Not Found", "<h1>404 Not Found</h1>");
             Debug::Log::error(std::format("Failed to open file: {}", path), "RequestHandler");
         }
     }
 
-    void RequestHandler::handlePhpRequest(const std::string& path, std::stringstream& requestStream, std::stringstream& responseStream) {
-        // Check if PHP is available
-        std::string phpCommand = std::string(
-#ifdef _WIN32
-                "php --version"
-#else
-                "php-cgi --version"
-#endif
-        );
-        if (std::system((phpCommand + " >nul 2>&1").c_str()) != 0) {
-            responseStream.str("HTTP/1.1 500 Internal Server Error\r\nContent-Type: text/html\r\nConnection: close\r\n\r\n<h1>500 Internal Server Error</h1><p>PHP is not installed or not found in PATH.</p>");
+    void RequestHandler::sendCachedFile(std::shared_ptr<const System::FileCache::Entry> entry, Variant variant,
+                                        const HttpRequest& request, const System::HtaccessConfig& config, HttpResponse& response) {
+        if (variant.dynamic) {
+            bool claimed = false;
+            std::shared_ptr<const System::FileCache::Entry> compressed;
+            if (entry->size >= config.compressionMinSize) {
+                compressed = fileCache_->findCompressed(*entry, variant.coding, claimed);
+            }
+            if (claimed) {
+                // Compress once on the compression threads, later requests find the variant in the cache.
+                // This first response ignores Range and validators and sends the whole new body
+                response.finish = [cache = fileCache_, entry, coding = variant.coding, level = config.compressionLevel,
+                                   contentType = response.contentType](HttpResponse& finished) {
+                    std::shared_ptr<const System::FileCache::Entry> sent = entry;
+                    auto body = Compressor::compress(*entry->body, coding, level);
+                    if (body && body->size() < entry->size) {
+                        std::string name(ContentEncoding::name(coding));
+                        sent = System::FileCache::makeVariant(*entry, std::move(*body), "-" + name, contentType,
+                                                              std::format("Content-Encoding: {}\r\nVary: Accept-Encoding\r\n", name));
+                        cache->storeCompressed(*entry, coding, sent);
+                    } else {
+                        cache->storeCompressed(*entry, coding, nullptr);
+                    }
+                    finished.sharedHeaders = sent->headers;
+                    finished.sharedBody = sent->body;
+                };
+                return;
+            }
+            if (!compressed || compressed->body == entry->body) {
+                // Too small, not worth it, or still being compressed by another request
+                variant.coding = ContentEncoding::Identity;
+            }
+            if (compressed) {
+                entry = std::move(compressed);
+            }
+            variant.dynamic = false;
+        }
+
+        if (checkNotModified(request, entry->etag, entry->lastModified, response)) {
+            addVariantHeaders(variant, response);
+            LOG_DEBUG("RequestHandler", "Not modified: {}", entry->path);
+            return;
+        }
+        response.sharedBody = entry->body;
+        if (applyRange(request, entry->etag, entry->lastModified, entry->size, response)) {
+            addVariantHeaders(variant, response);
+        } else {
+            // Content-Encoding and Vary are part of the pre-built lines
+            response.sharedHeaders = entry->headers;
+        }
+    }
+
+    void RequestHandler::compressBody(unsigned accepted, const System::HtaccessConfig& config, HttpResponse& response) {
+        if (!compressor_ || !config.compression || response.status != "200 OK" || response.file || response.sharedBody
+            || !config.isCompressible(response.contentType)) {
+            return;
+        }
+        response.headers.emplace_back("Vary", "Accept-Encoding");
+        auto coding = ContentEncoding::select(accepted & Compressor::available());
+        if (coding == ContentEncoding::Identity) {
+            return;
+        }
+        if (response.stream) {
+            // The size is not known in advance, every piece is compressed as it passes
+            if (auto encoder = Compressor::encoder(coding, config.compressionLevel)) {
+                response.stream = std::make_shared<CompressedBodyStream>(std::move(response.stream), std::move(encoder), compressor_);
+                response.headers.emplace_back("Content-Encoding", std::string(ContentEncoding::name(coding)));
+            }
+            return;
+        }
+        if (response.body.size() < config.compressionMinSize) {
+            return;
+        }
+        response.finish = [coding, level = config.compressionLevel](HttpResponse& finished) {
+            auto body = Compressor::compress(finished.body, coding, level);
+            if (body && body->size() < finished.body.size()) {
+                finished.body = std::move(*body);
+                finished.headers.emplace_back("Content-Encoding", std::string(ContentEncoding::name(coding)));
+            }
+        };
+    }
+
+    void RequestHandler::addVariantHeaders(const Variant& variant, HttpResponse& response) {
+        if (variant.coding != ContentEncoding::Identity && response.status.starts_with('2')) {
+            response.headers.emplace_back("Content-Encoding", std::string(ContentEncoding::name(variant.coding)));
+        }
+        if (variant.vary) {
+            response.headers.emplace_back("Vary", "Accept-Encoding");
+        }
+    }
+
+    bool RequestHandler::checkNotModified(const HttpRequest& request, const std::string& etag, std::time_t lastModified,
+                                          HttpResponse& response) {
+        // If-None-Match takes precedence, If-Modified-Since is only evaluated without it (RFC 7232 6)
+        if (auto ifNoneMatch = request.header("If-None-Match"); !ifNoneMatch.empty()) {
+            std::size_t pos = 0;
+            while (pos < ifNoneMatch.size()) {
+                std::size_t end = ifNoneMatch.find(',', pos);
+                if (end == std::string_view::npos) end = ifNoneMatch.size();
+                std::string_view candidate = ifNoneMatch.substr(pos, end - pos);
+                while (!candidate.empty() && (candidate.front() == ' ' || candidate.front() == '\t')) candidate.remove_prefix(1);
+                while (!candidate.empty() && (candidate.back() == ' ' || candidate.back() == '\t')) candidate.remove_suffix(1);
+                // Weak comparison, a W/ prefix on either side is ignored
+                if (candidate.starts_with("W/")) candidate.remove_prefix(2);
+                if (candidate == "*" || candidate == etag) {
+                    response.setNotModified(etag, lastModified);
+                    return true;
+                }
+                pos = end + 1;
+            }
+            return false;
+        }
+
+        if (request.method != "GET" && request.method != "HEAD") {
+            return false;
+        }
+        if (auto ifModifiedSince = request.header("If-Modified-Since"); !ifModifiedSince.empty()) {
+            auto since = HttpDate::parse(ifModifiedSince);
+            if (since && lastModified <= *since) {
+                response.setNotModified(etag, lastModified);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool RequestHandler::applyRange(const HttpRequest& request, const std::string& etag, std::time_t lastModified,
+                                    std::uint64_t size, HttpResponse& response) {
+        auto rangeHeader = request.header("Range");
+        if (rangeHeader.empty() || request.method != "GET") {
+            return false;
+        }
+        // If-Range: only send a part when the client still holds the current version (strong comparison)
+        if (auto ifRange = request.header("If-Range"); !ifRange.empty()) {
+            bool current = ifRange.starts_with('"') ? ifRange == etag : HttpDate::parse(ifRange) == lastModified;
+            if (!current) {
+                return false;
+            }
+        }
+
+        std::vector<ByteRange> ranges;
+        switch (HttpRange::parse(rangeHeader, size, ranges)) {
+            case HttpRange::Result::Ignore:
+                return false;
+            case HttpRange::Result::Unsatisfiable:
+                response.setError("416 Range Not Satisfiable", "<h1>416 Range Not Satisfiable</h1>");
+                response.headers.emplace_back("Content-Range", std::format("bytes */{}", size));
+                return true;
+            case HttpRange::Result::Satisfiable:
+                break;
+        }
+
+        response.status = "206 Partial Content";
+        response.headers.emplace_back("ETag", etag);
+        response.headers.emplace_back("Last-Modified", HttpDate::format(lastModified));
+        if (ranges.size() == 1) {
+            const ByteRange& range = ranges.front();
+            response.headers.emplace_back("Content-Range",
+                                          std::format("bytes {}-{}/{}", range.offset, range.offset + range.length - 1, size));
+            response.parts.push_back({std::string(), range.offset, range.length});
+            return true;
+        }
+
+        // multipart/byteranges: every part names its range, the body source is sliced without copying
+        thread_local std::mt19937_64 generator{std::random_device{}()};
+        std::string boundary = std::format("{:016x}{:016x}", generator(), generator());
+        for (const auto& range : ranges) {
+            response.parts.push_back({std::format("\r\n--{}\r\nContent-Type: {}\r\nContent-Range: bytes {}-{}/{}\r\n\r\n",
+                                                  boundary, response.contentType, range.offset,
+                                                  range.offset + range.length - 1, size),
+                                      range.offset, range.length});
+        }
+        response.parts.push_back({std::format("\r\n--{}--\r\n", boundary), 0, 0});
+        response.contentType = "multipart/byteranges; boundary=" + boundary;
+        return true;
+    }
+
+    RequestHandler::StoredRequest::StoredRequest(const HttpRequest& original)
+            : method(original.method), target(original.target), version(original.version),
+              remoteAddress(original.remoteAddress), localAddress(original.localAddress) {
+        headers.reserve(original.headers.size());
+        for (const auto& header : original.headers) {
+            headers.emplace_back(std::string(header.name), std::string(header.value));
+        }
+        request.method = method;
+        request.target = target;
+        request.version = version;
+        for (const auto& [name, value] : headers) {
+            request.headers.push_back({name, value});
+        }
+        request.contentLength = original.contentLength;
+        request.body = {}; // Only requests without a body are cached
+        request.remoteAddress = remoteAddress;
+        request.remotePort = original.remotePort;
+        request.localAddress = localAddress;
+        request.localPort = original.localPort;
+    }
+
+    void RequestHandler::runPhpScript(const std::string& path, const HttpRequest& request, const boost::asio::any_io_executor& executor,
+                                      std::shared_ptr<const System::HtaccessConfig> config, std::shared_ptr<MicroCache::Fill> fill,
+                                      HttpResponse& response) {
+        handlePhpRequest(path, request, executor, config, response, std::move(fill));
+        if (!response.deferred) {
+            compressBody(ContentEncoding::accepted(request.header("Accept-Encoding")), *config, response);
+        }
+    }
+
+    void RequestHandler::handleCachedPhpRequest(const std::string& path, const HttpRequest& request,
+                                                const boost::asio::any_io_executor& executor,
+                                                std::shared_ptr<const System::HtaccessConfig> config, HttpResponse& response) {
+        std::string key = MicroCache::key(request, config->microCacheVary);
+        if (key.empty()) {
+            runPhpScript(path, request, executor, std::move(config), nullptr, response);
+            return;
+        }
+        auto lookup = microCache_->lookup(key, *config);
+        switch (lookup.status) {
+            case MicroCache::Status::Hit:
+                sendMicroCached(lookup.entry, ContentEncoding::accepted(request.header("Accept-Encoding")), *config, response);
+                LOG_DEBUG("RequestHandler", "Served PHP file from microcache: {}", path);
+                return;
+            case MicroCache::Status::Stale:
+                if (lookup.fill) {
+                    refreshCachedPhpRequest(path, request, executor, config, std::move(lookup.fill));
+                }
+                sendMicroCached(lookup.entry, ContentEncoding::accepted(request.header("Accept-Encoding")), *config, response);
+                LOG_DEBUG("RequestHandler", "Served stale PHP file from microcache: {}", path);
+                return;
+            case MicroCache::Status::Miss:
+                runPhpScript(path, request, executor, std::move(config), std::move(lookup.fill), response);
+                return;
+            case MicroCache::Status::Pass:
+                runPhpScript(path, request, executor, std::move(config), nullptr, response);
+                return;
+            case MicroCache::Status::Busy:
+                break;
+        }
+
+        // Another request runs the script, this one is answered with its response. Without one (not
+        // cacheable, failed) the script runs for this request too
+        auto stored = std::make_shared<StoredRequest>(request);
+        response.deferred = [self = shared_from_this(), path, key = std::move(key), stored, executor, config,
+                             keepAlive = response.keepAlive, contentType = response.contentType](HttpResponse::Completion done) {
+            self->microCache_->wait(key, [self, path, stored, executor, config, keepAlive, contentType,
+                                          done = std::move(done)](std::shared_ptr<const MicroCache::Entry> entry) {
+                HttpResponse result;
+                result.keepAlive = keepAlive;
+                if (entry) {
+                    self->sendMicroCached(std::move(entry), ContentEncoding::accepted(stored->request.header("Accept-Encoding")),
+                                          *config, result);
+                } else {
+                    result.contentType = contentType;
+                    self->runPhpScript(path, stored->request, executor, config, nullptr, result);
+                }
+                done(std::move(result));
+            });
+        };
+    }
+
+    void RequestHandler::sendMicroCached(std::shared_ptr<const MicroCache::Entry> entry, unsigned accepted,
+                                         const System::HtaccessConfig& config, HttpResponse& response) {
+        response.status = entry->status;
+        response.contentType = entry->contentType;
+        response.headers = entry->headers;
+        response.sharedBody = entry->body;
+        if (!compressor_ || !config.compression || response.status != "200 OK" || !config.isCompressible(response.contentType)) {
+            return;
+        }
+        response.headers.emplace_back("Vary", "Accept-Encoding");
+        auto coding = ContentEncoding::select(accepted & Compressor::available());
+        if (coding == ContentEncoding::Identity || entry->body->size() < config.compressionMinSize) {
+            return;
+        }
+        bool claimed = false;
+        auto compressed = microCache_->findCompressed(*entry, coding, claimed);
+        if (claimed) {
+            // Compressed once on the compression threads, later hits send the stored body
+            response.finish = [cache = microCache_, entry, coding, level = config.compressionLevel](HttpResponse& finished) {
+                auto body = Compressor::compress(*entry->body, coding, level);
+                if (body && body->size() < entry->body->size()) {
+                    auto shared = std::make_shared<const std::string>(std::move(*body));
+                    cache->storeCompressed(*entry, coding, shared);
+                    finished.sharedBody = std::move(shared);
+                    finished.headers.emplace_back("Content-Encoding", std::string(ContentEncoding::name(coding)));
+                } else {
+                    cache->storeCompressed(*entry, coding, nullptr);
+                }
+            };
+            return;
+        }
+        if (compressed && compressed != entry->body) {
+            response.sharedBody = std::move(compressed);
+            response.headers.emplace_back("Content-Encoding", std::string(ContentEncoding::name(coding)));
+        }
+    }
+
+    void RequestHandler::refreshCachedPhpRequest(const std::string& path, const HttpRequest& request,
+                                                 const boost::asio::any_io_executor& executor,
+                                                 std::shared_ptr<const System::HtaccessConfig> config,
+                                                 std::shared_ptr<MicroCache::Fill> fill) {
+        // Nobody receives this response, so it is not compressed
+        StoredRequest stored(request);
+        std::erase_if(stored.request.headers, [](const HttpHeader& header) {
+            return equalsIgnoreCase(header.name, "Accept-Encoding");
+        });
+        HttpResponse response;
+        runPhpScript(path, stored.request, executor, std::move(config), std::move(fill), response);
+        if (response.deferred) {
+            response.deferred([executor](HttpResponse&& produced) {
+                if (produced.stream) {
+                    drainBody(std::move(produced.stream), executor);
+                }
+            });
+        }
+    }
+
+    void RequestHandler::drainBody(std::shared_ptr<BodyStream> body, const boost::asio::any_io_executor& executor) {
+        body->read([body, executor](const boost::system::error_code& error, std::string_view) {
+            if (!error) {
+                boost::asio::post(executor, [body, executor]() {
+                    drainBody(body, executor);
+                });
+            }
+        });
+    }
+
+    void RequestHandler::handlePhpRequest(const std::string& path, const HttpRequest& request,
+                                          const boost::asio::any_io_executor& executor,
+                                          std::shared_ptr<const System::HtaccessConfig> config, HttpResponse& response,
+                                          std::shared_ptr<MicroCache::Fill> fill) {
+        if (!config->phpFastCgi.empty() && fastCgiClient_) {
+            handlePhpFastCgiRequest(path, request, std::move(config), response, std::move(fill));
+            return;
+        }
+        // The interpreter was located at startup, it is only looked for again while missing
+        auto php = php_->get();
+        if (!php->isAvailable()) {
+            php = php_->reprobe();
+        }
+        if (!php->isAvailable()) {
+            response.setError("500 Internal Server Error", "<h1>500 Internal Server Error</h1><p>PHP is not installed or not found in PATH.</p>");
             Debug::Log::error("PHP is not installed or not found in PATH", "RequestHandler");
             return;
         }
+        if (config->phpWorkers > 0 && System::PhpWorkerPool::isSupported()) {
+            handlePhpPoolRequest(path, request, php->path, std::move(config), response, std::move(fill));
+            return;
+        }
 
         // Prepare PHP command
-        std::string command = std::string(
-#ifdef _WIN32
-                "php \""
-#else
-                "php-cgi \""
-#endif
-        ) + path + "\"";
-
 #ifdef _WIN32
+        std::string command = "\"\"" + php->path + "\" \"" + path + "\"\""; // cmd strips the outer quotes
         FILE* pipe = _popen(command.c_str(), "r");
 #else
+        if (CgiProcess::isSupported()) {
+            // php-cgi takes the script and request from the CGI variables, the body comes through stdin.
+            // The output is sent while the script runs, a slow client blocks it on the full pipe
+            std::vector<std::string> environment;
+            for (auto& [name, value] : cgiParams(path, request)) {
+                environment.push_back(name + "=" + value);
+            }
+            if (const char* searchPath = std::getenv("PATH")) {
+                environment.push_back(std::string("PATH=") + searchPath);
+            }
+            auto process = CgiProcess::start(executor, {php->path}, environment, std::string(request.body));
+            if (!process) {
+                response.setError("500 Internal Server Error", "<h1>500 Internal Server Error</h1>");
+                Debug::Log::error(std::format("Failed to execute PHP script: {}", path), "RequestHandler");
+                php_->reprobe();
+                return;
+            }
+            auto context = scriptContext(path, request, std::move(config), response, std::move(fill));
+            response.deferred = [self = shared_from_this(), process, context](HttpResponse::Completion done) {
+                self->completeScriptResponse(process, context, std::move(done));
+            };
+            return;
+        }
+        std::string command = "\"" + php->path + "\" \"" + path + "\"";
         FILE* pipe = popen(command.c_str(), "r");
 #endif
         if (!pipe) {
-            responseStream.str("HTTP/1.1 500 Internal Server Error\r\nContent-Type: text/html\r\nConnection: close\r\n\r\n<h1>500 Internal Server Error</h1>");
+            response.setError("500 Internal Server Error", "<h1>500 Internal Server Error</h1>");
             Debug::Log::error(std::format("Failed to execute PHP script: {}", path), "RequestHandler");
+            php_->reprobe();
             return;
         }
 
@@ -132,13 +603,235 @@ namespace Network {
         }
 
 #ifdef _WIN32
-        _pclose(pipe);
+        int status = _pclose(pipe);
 #else
-        pclose(pipe);
+        int status = pclose(pipe);
 #endif
+        if (status != 0 && phpOutput.tellp() == 0) {
+            // Nothing ran, the binary may have been removed or replaced
+            php_->reprobe();
+        }
 
-        responseStream << phpOutput.str();
-        Debug::Log::info(std::format("Served PHP file: {}", path), "RequestHandler");
+        response.body = phpOutput.str();
+#ifndef _WIN32
+        // php-cgi starts its output with the CGI header block, the Windows CLI binary does not
+        CgiResponse headers;
+        if (headers.parse(response.body) == CgiResponse::Result::Complete) {
+            headers.apply(response);
+            response.body = std::string(headers.body());
+        }
+#endif
+        if (fill) {
+            fill->store(response);
+        }
+        LOG_DEBUG("RequestHandler", "Served PHP file: {}", path);
+    }
+
+    std::shared_ptr<System::PhpWorkerPool> RequestHandler::getPhpPool(const System::HtaccessConfig& config,
+                                                                      const std::string& binary) {
+        System::PhpWorkerPool::Settings settings;
+        settings.binary = binary;
+        settings.workers = config.phpWorkers;
+        settings.maxRequests = config.phpMaxRequests;
+        settings.queueSize = static_cast<std::size_t>(config.phpQueueSize);
+        std::lock_guard<std::mutex> guard(phpPoolMutex_);
+        if (!phpPool_ || phpPool_->getSettings() != settings) {
+            // Requests still running keep the old pool alive until they finish
+            phpPool_ = std::make_shared<System::PhpWorkerPool>(std::move(settings));
+        }
+        return phpPool_;
+    }
+
+    std::vector<std::pair<std::string, std::string>> RequestHandler::cgiParams(const std::string& path,
+                                                                              const HttpRequest& request) const {
+        // Host without the port, the local address for HTTP/1.0 clients that sent none
+        std::string serverName(request.header("Host"));
+        if (auto colon = serverName.rfind(':'); colon != std::string::npos && serverName.find(']', colon) == std::string::npos) {
+            serverName.resize(colon);
+        }
+        if (serverName.empty()) {
+            serverName = request.localAddress;
+        }
+        std::vector<std::pair<std::string, std::string>> params = {
+                {"GATEWAY_INTERFACE", "CGI/1.1"},
+                {"SERVER_SOFTWARE", "WebServer"},
+                {"SERVER_PROTOCOL", std::string(request.version)},
+                {"REQUEST_METHOD", std::string(request.method)},
+                {"REQUEST_URI", std::string(request.target)},
+                {"QUERY_STRING", std::string(request.query())},
+                {"SCRIPT_FILENAME", path},
+                {"SCRIPT_NAME", path.substr(std::min(path.size(), rootDir_.size()))},
+                {"DOCUMENT_ROOT", rootDir_},
+                {"SERVER_NAME", serverName},
+                {"SERVER_ADDR", std::string(request.localAddress)},
+                {"SERVER_PORT", std::to_string(request.localPort)},
+                {"REMOTE_ADDR", std::string(request.remoteAddress)},
+                {"REMOTE_PORT", std::to_string(request.remotePort)},
+                {"REDIRECT_STATUS", "200"}, // Required by php-cgi's force-cgi-redirect check
+        };
+        if (request.contentLength > 0) {
+            params.emplace_back("CONTENT_LENGTH", std::to_string(request.contentLength));
+        }
+        for (const auto& header : request.headers) {
+            if (equalsIgnoreCase(header.name, "Content-Type")) {
+                params.emplace_back("CONTENT_TYPE", std::string(header.value));
+                continue;
+            }
+            if (equalsIgnoreCase(header.name, "Content-Length") || equalsIgnoreCase(header.name, "Proxy")) {
+                continue;
+            }
+            std::string name = "HTTP_";
+            for (char c : header.name) {
+                name += c == '-' ? '_' : static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+            }
+            params.emplace_back(std::move(name), std::string(header.value));
+        }
+        return params;
+    }
+
+    void RequestHandler::streamBody(std::shared_ptr<BodyStream> body, bool chunked, HttpResponse& response) {
+        response.stream = std::move(body);
+        response.chunked = chunked;
+        if (!chunked) {
+            response.keepAlive = false; // HTTP/1.0 clients see the end of the body when the connection closes
+        }
+    }
+
+    std::shared_ptr<const RequestHandler::ScriptContext> RequestHandler::scriptContext(const std::string& path, const HttpRequest& request,
+                                                                                  std::shared_ptr<const System::HtaccessConfig> config,
+                                                                                  const HttpResponse& response,
+                                                                                  std::shared_ptr<MicroCache::Fill> fill) {
+        auto context = std::make_shared<ScriptContext>();
+        context->config = std::move(config);
+        context->path = path;
+        context->accepted = ContentEncoding::accepted(request.header("Accept-Encoding"));
+        context->keepAlive = response.keepAlive;
+        context->chunked = request.version == "HTTP/1.1";
+        context->fill = std::move(fill);
+        return context;
+    }
+
+    void RequestHandler::completeScriptResponse(std::shared_ptr<BodyStream> output, std::shared_ptr<const ScriptContext> context,
+                                                HttpResponse::Completion done) {
+        auto body = std::make_shared<CgiBodyStream>(std::move(output));
+        body->readHeaders([self = shared_from_this(), body, context, done = std::move(done)](const boost::system::error_code& error,
+                                                                                           const CgiResponse& headers) {
+            HttpResponse response;
+            response.keepAlive = context->keepAlive;
+            if (error && context->fill) {
+                context->fill->abandon();
+            }
+            if (error == boost::asio::error::timed_out) {
+                response.setError("504 Gateway Timeout", "<h1>504 Gateway Timeout</h1><p>The PHP script did not finish in time.</p>");
+            } else if (error) {
+                Debug::Log::error(std::format("No valid CGI response from {}: {}", context->path, error.message()), "RequestHandler");
+                response.setError("502 Bad Gateway", "<h1>502 Bad Gateway</h1><p>The PHP worker failed.</p>");
+            } else {
+                headers.apply(response);
+                std::string_view code = std::string_view(response.status).substr(0, 3);
+                if (code.starts_with('1') || code == "204" || code == "304") {
+                    response.notModified = true; // Sent without body or content headers
+                    if (context->fill) {
+                        context->fill->abandon(true);
+                    }
+                } else {
+                    // Stored before compression, every hit negotiates its own coding
+                    streamBody(context->fill ? context->fill->capture(response, body) : body, context->chunked, response);
+                    bool encoded = std::any_of(response.headers.begin(), response.headers.end(), [](const auto& header) {
+                        return equalsIgnoreCase(header.first, "Content-Encoding");
+                    });
+                    if (!encoded) {
+                        self->compressBody(context->accepted, *context->config, response);
+                    }
+                }
+                LOG_DEBUG("RequestHandler", "Serving PHP file: {} ({})", context->path, response.status);
+            }
+            done(std::move(response));
+        });
+    }
+
+    void RequestHandler::logFastCgiResult(const std::string& path, const std::string& errors, const boost::system::error_code& error) {
+        if (!errors.empty()) {
+            Debug::Log::error(std::format("PHP error in {}: {}", path, errors), "RequestHandler");
+        }
+        if (error == boost::asio::error::timed_out) {
+            Debug::Log::error(std::format("PHP script timed out: {}", path), "RequestHandler");
+        } else if (error) {
+            Debug::Log::error(std::format("FastCGI request for {} failed: {}", path, error.message()), "RequestHandler");
+        }
+    }
+
+    void RequestHandler::handlePhpFastCgiRequest(const std::string& path, const HttpRequest& request,
+                                                 std::shared_ptr<const System::HtaccessConfig> config, HttpResponse& response,
+                                                 std::shared_ptr<MicroCache::Fill> fill) {
+        // Everything needed later is copied now, the request views do not outlive processRequest
+        auto params = cgiParams(path, request);
+        std::string body(request.body);
+        auto context = scriptContext(path, request, std::move(config), response, std::move(fill));
+        response.deferred = [self = shared_from_this(), context, params = std::move(params),
+                             body = std::move(body)](HttpResponse::Completion done) mutable {
+            // The upstream connection is shared and cannot wait for one slow client, past the limit the request fails
+            auto output = std::make_shared<QueueBodyStream>(sharedOutputLimit);
+            auto errors = std::make_shared<std::string>();
+            self->completeScriptResponse(output, context, std::move(done));
+            FastCgiClient::Handlers handlers;
+            handlers.onOutput = [output](std::string_view data) { return output->push(data); };
+            handlers.onErrors = [errors](std::string_view data) { errors->append(data); };
+            handlers.onComplete = [context, output, errors](const boost::system::error_code& error, std::uint32_t) {
+                logFastCgiResult(context->path, *errors, error);
+                output->close(error);
+            };
+            self->fastCgiClient_->request(context->config->phpFastCgi, std::move(params), std::move(body), std::move(handlers));
+        };
+    }
+
+    void RequestHandler::handlePhpPoolRequest(const std::string& path, const HttpRequest& request, const std::string& binary,
+                                              std::shared_ptr<const System::HtaccessConfig> config, HttpResponse& response,
+                                              std::shared_ptr<MicroCache::Fill> fill) {
+        // The records are encoded now, the request views do not outlive processRequest
+        std::string records;
+        FastCgi::appendBeginRequest(records, 1, false);
+        FastCgi::appendParams(records, 1, cgiParams(path, request));
+        FastCgi::appendStdin(records, 1, request.body);
+
+        auto pool = getPhpPool(*config, binary);
+        auto context = scriptContext(path, request, std::move(config), response, std::move(fill));
+        response.deferred = [self = shared_from_this(), pool, context, records = std::move(records)](HttpResponse::Completion done) mutable {
+            auto fail = [keepAlive = context->keepAlive](const std::string& status, const std::string& message) {
+                HttpResponse failed;
+                failed.keepAlive = keepAlive;
+                failed.setError(status, std::format("<h1>{}</h1><p>{}</p>", status, message));
+                return failed;
+            };
+            auto onLease = [self, pool, context, fail, records = std::move(records), done]
+                    (std::optional<System::PhpWorkerPool::Lease> lease) mutable {
+                if (!lease) {
+                    Debug::Log::error("No php-cgi worker could be started", "RequestHandler");
+                    self->php_->reprobe();
+                    done(fail("500 Internal Server Error", "PHP is not installed or not found in PATH."));
+                    return;
+                }
+                auto output = std::make_shared<QueueBodyStream>();
+                self->completeScriptResponse(output, context, std::move(done));
+                auto window = lease->starting ? std::chrono::milliseconds(3000) : std::chrono::milliseconds(0);
+                FastCgiRequest::start(pool->getIoContext(), lease->endpoint, std::move(records), window, std::chrono::seconds(30),
+                                      [pool, context, output, lease = *lease](const boost::system::error_code& error,
+                                                                              FastCgiRequest::Result&& result) {
+                    pool->release(lease, static_cast<bool>(error));
+                    logFastCgiResult(context->path, result.errors, error);
+                    output->close(error);
+                }, [output](std::string_view data, const std::function<void()>& resume) {
+                    // The worker's socket is read again once a slow client caught up
+                    return output->push(data, resume);
+                });
+            };
+            if (!pool->acquire(std::move(onLease))) {
+                Debug::Log::error(std::format("PHP worker queue full, rejecting {}", context->path), "RequestHandler");
+                HttpResponse busy = fail("503 Service Unavailable", "All PHP workers are busy.");
+                busy.headers.emplace_back("Retry-After", "1");
+                done(std::move(busy));
+            }
+        };
     }
 
 } // namespace Network
\ No newline at end of file
@@ -2,30 +2,188 @@
 #define REQUESTHANDLER_H
 
 #include <boost/asio.hpp>
+#include <atomic>
+#include <ctime>
+#include <filesystem>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include "BodyStream.h"
+#include "Compressor.h"
+#include "ContentEncoding.h"
+#include "FastCgiClient.h"
+#include "HttpParser.h"
+#include "HttpResponse.h"
+#include "MicroCache.h"
+#include "../System/FileCache.h"
 #include "../System/HtaccessConfig.h"
+#include "../System/PhpInterpreter.h"
+#include "../System/PhpWorkerPool.h"
 
 namespace Network {
 
-class RequestHandler {
+class RequestHandler : public std::enable_shared_from_this<RequestHandler> {
 public:
-    // Constructor
-    RequestHandler(boost::asio::io_context& ioContext, const std::string& rootDir);
+    // Constructor, fileCache may be null to always serve from disk, compressor null to never compress,
+    // fastCgiClient null to ignore PhpFastCgi and php null to probe for the interpreter here
+    RequestHandler(boost::asio::io_context& ioContext, const std::string& rootDir,
+                   std::shared_ptr<System::FileCache> fileCache = nullptr, std::shared_ptr<Compressor> compressor = nullptr,
+                   std::shared_ptr<FastCgiClient> fastCgiClient = nullptr, std::shared_ptr<System::PhpInterpreter> php = nullptr);
 
-    // Handle incoming HTTP request
-    void handleRequest(std::shared_ptr<boost::asio::ip::tcp::socket> socket);
+    // Handle incoming HTTP connection asynchronously, onClose runs once the connection is finished
+    // and onRequest after every request read from it
+    void handleRequest(std::shared_ptr<boost::asio::ip::tcp::socket> socket, std::function<void()> onClose = {},
+                       std::function<void()> onRequest = {});
+
+    // Build the HTTP response for a parsed request head, allowKeepAlive is false once the connection must close.
+    // Script output pipes are read on executor, the connection's strand
+    HttpResponse processRequest(const HttpRequest& request, bool allowKeepAlive, const boost::asio::any_io_executor& executor);
+
+    // Run response.finish on the compression threads (inline without them), then hand the response to done
+    void finishResponse(HttpResponse&& response, std::function<void(HttpResponse&&)> done);
+
+    // Configuration from .htaccess, replaced as a whole when the file changes
+    std::shared_ptr<const System::HtaccessConfig> getConfig() const { return htaccessConfig_.load(); }
+
+    // Re-parse .htaccess
+    void reloadConfig();
+
+    // React to a change below the root directory: drop cached files and reload .htaccess
+    void onFileChanged(const std::filesystem::path& path, bool subtree);
+
+    // Counters of the PHP response microcache
+    MicroCache::Stats getMicroCacheStats() const { return microCache_->getStats(); }
 
 private:
+    // File sent for a request: the requested file itself, a precompressed sidecar of it, or the
+    // file compressed on the fly (dynamic)
+    struct Variant {
+        std::string path;
+        ContentEncoding::Coding coding = ContentEncoding::Identity;
+        bool dynamic = false;
+        bool vary = false; // The response depends on Accept-Encoding
+    };
+
+    // Pick the sidecar or on-the-fly coding matching Accept-Encoding, sidecar existence comes from the file cache
+    Variant selectVariant(const std::string& path, const HttpRequest& request, const System::HtaccessConfig& config,
+                          const std::string& contentType);
+
     // Serve static file content
-    void serveStaticFile(const std::string& path, std::stringstream& responseStream);
+    void serveStaticFile(const Variant& variant, const HttpRequest& request, const System::HtaccessConfig& config,
+                         HttpResponse& response);
+
+    // Answer from a cache entry: 304, 206 or the pre-built headers and shared body, compressing it first if needed
+    void sendCachedFile(std::shared_ptr<const System::FileCache::Entry> entry, Variant variant, const HttpRequest& request,
+                        const System::HtaccessConfig& config, HttpResponse& response);
+
+    // Compress a generated body or stream (PHP output) on the compression threads, accepted is the Accept-Encoding mask
+    void compressBody(unsigned accepted, const System::HtaccessConfig& config, HttpResponse& response);
+
+    // Content-Encoding and Vary for responses not using the pre-built header lines
+    void addVariantHeaders(const Variant& variant, HttpResponse& response);
+
+    // Evaluate If-None-Match/If-Modified-Since and turn the response into a 304 when they match
+    bool checkNotModified(const HttpRequest& request, const std::string& etag, std::time_t lastModified,
+                          HttpResponse& response);
+
+    // Evaluate Range/If-Range and turn the response into a 206 or 416, false if the full body is to be sent
+    bool applyRange(const HttpRequest& request, const std::string& etag, std::time_t lastModified, std::uint64_t size,
+                    HttpResponse& response);
+
+    // CGI/1.1 meta-variables for a script: FastCGI PARAMS, or the environment of a php-cgi child
+    std::vector<std::pair<std::string, std::string>> cgiParams(const std::string& path, const HttpRequest& request) const;
+
+    // What completing a script response needs once processRequest returned
+    struct ScriptContext {
+        std::shared_ptr<const System::HtaccessConfig> config;
+        std::string path;
+        unsigned accepted = 0; // Accept-Encoding mask
+        bool keepAlive = false;
+        bool chunked = false; // HTTP/1.1 client
+        std::shared_ptr<MicroCache::Fill> fill; // Stores the response in the microcache when set
+    };
+
+    // Copy what the response needs from the request, whose views do not outlive processRequest
+    static std::shared_ptr<const ScriptContext> scriptContext(const std::string& path, const HttpRequest& request,
+                                                              std::shared_ptr<const System::HtaccessConfig> config,
+                                                              const HttpResponse& response, std::shared_ptr<MicroCache::Fill> fill);
+
+    // Send the body as it is produced, chunked for HTTP/1.1 clients and ended by closing the connection otherwise
+    static void streamBody(std::shared_ptr<BodyStream> body, bool chunked, HttpResponse& response);
+
+    // Read the CGI header block from a script's output and complete the response from it, the rest is
+    // streamed as the body. A failure before the block gives 502, or 504 for a timeout
+    void completeScriptResponse(std::shared_ptr<BodyStream> output, std::shared_ptr<const ScriptContext> context,
+                                HttpResponse::Completion done);
+
+    // Log STDERR and the outcome of a FastCGI request
+    static void logFastCgiResult(const std::string& path, const std::string& errors, const boost::system::error_code& error);
+
+    // Request copied for work that outlives processRequest, request holds views into the copied strings
+    struct StoredRequest {
+        explicit StoredRequest(const HttpRequest& original);
+        StoredRequest(const StoredRequest&) = delete;
+        StoredRequest& operator=(const StoredRequest&) = delete;
+
+        std::string method;
+        std::string target;
+        std::string version;
+        std::vector<std::pair<std::string, std::string>> headers;
+        std::string remoteAddress;
+        std::string localAddress;
+        HttpRequest request;
+    };
+
+    // Answer a PHP request from the microcache: a hit, a stale entry while one request refreshes it,
+    // the response of a concurrent run of the same request, or running the script and storing its response
+    void handleCachedPhpRequest(const std::string& path, const HttpRequest& request, const boost::asio::any_io_executor& executor,
+                                std::shared_ptr<const System::HtaccessConfig> config, HttpResponse& response);
+
+    // Fill response from a microcache entry, compressing the body once per coding
+    void sendMicroCached(std::shared_ptr<const MicroCache::Entry> entry, unsigned accepted, const System::HtaccessConfig& config,
+                         HttpResponse& response);
+
+    // Run the script for an expired entry without a client, reading its output to the end
+    void refreshCachedPhpRequest(const std::string& path, const HttpRequest& request, const boost::asio::any_io_executor& executor,
+                                 std::shared_ptr<const System::HtaccessConfig> config, std::shared_ptr<MicroCache::Fill> fill);
+
+    // Read a body nobody sends so the producer runs to its end
+    static void drainBody(std::shared_ptr<BodyStream> body, const boost::asio::any_io_executor& executor);
+
+    // Run a PHP script and compress its response, fill (may be null) stores it in the microcache
+    void runPhpScript(const std::string& path, const HttpRequest& request, const boost::asio::any_io_executor& executor,
+                      std::shared_ptr<const System::HtaccessConfig> config, std::shared_ptr<MicroCache::Fill> fill,
+                      HttpResponse& response);
+
+    // Handle PHP script execution: on the PhpFastCgi server if set, else through the worker pool unless PhpWorkers is 0
+    void handlePhpRequest(const std::string& path, const HttpRequest& request, const boost::asio::any_io_executor& executor,
+                          std::shared_ptr<const System::HtaccessConfig> config, HttpResponse& response,
+                          std::shared_ptr<MicroCache::Fill> fill);
+
+    // Run the script through a php-cgi child, the response is completed once its output starts
+    void handlePhpPoolRequest(const std::string& path, const HttpRequest& request, const std::string& binary,
+                              std::shared_ptr<const System::HtaccessConfig> config, HttpResponse& response,
+                              std::shared_ptr<MicroCache::Fill> fill);
+
+    // Run the script on the external FastCGI server (php-fpm) set with PhpFastCgi
+    void handlePhpFastCgiRequest(const std::string& path, const HttpRequest& request,
+                                 std::shared_ptr<const System::HtaccessConfig> config, HttpResponse& response,
+                                 std::shared_ptr<MicroCache::Fill> fill);
 
-    // Handle PHP script execution
-    void handlePhpRequest(const std::string& path, std::stringstream& requestStream, std::stringstream& responseStream);
+    // Worker pool for the current PhpWorkers settings and binary, replaced when they change
+    std::shared_ptr<System::PhpWorkerPool> getPhpPool(const System::HtaccessConfig& config, const std::string& binary);
 
     boost::asio::io_context& ioContext_; // Reference to io_context for async operations
     std::string rootDir_; // Root directory for serving files
-    System::HtaccessConfig htaccessConfig_; // Configuration from .htaccess
+    std::atomic<std::shared_ptr<const System::HtaccessConfig>> htaccessConfig_; // Configuration from .htaccess
+    std::shared_ptr<System::FileCache> fileCache_; // Shared static file cache
+    std::shared_ptr<Compressor> compressor_; // Shared compression threads
+    std::shared_ptr<FastCgiClient> fastCgiClient_; // Shared connections to external FastCGI servers
+    std::shared_ptr<System::PhpInterpreter> php_; // Located PHP binary and version
+    std::shared_ptr<MicroCache> microCache_; // PHP responses, used when MicroCache is set
+    std::shared_ptr<System::PhpWorkerPool> phpPool_; // Started with the first PHP request
+    std::mutex phpPoolMutex_;
 };
 
 } // namespace Network
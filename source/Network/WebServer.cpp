@@ -1,29 +1,65 @@
 #include "WebServer.h"
 #include "../Debug/Log.h"
+#include <algorithm>
 
 namespace Network {
 
-    WebServer::WebServer(boost::asio::io_context& ioContext, const std::vector<std::pair<int, std::string>>& projects)
-            : ioContext_(ioContext), projects_(projects) {
-        for (const auto& [port, path] : projects) {
-            startAccept(port, path);
-        }
+#ifdef SO_REUSEPORT
+    // Lets every shard bind its own acceptor to the same port, the kernel balances accepts between them
+    using ReusePort = boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#endif
+
+    WebServer::WebServer(boost::asio::io_context& ioContext, const std::vector<std::pair<int, std::string>>& projects,
+                         std::size_t threadCount)
+            : ioContext_(ioContext), fileCache_(std::make_shared<System::FileCache>()),
+              compressor_(std::make_shared<Compressor>()), fastCgiClient_(std::make_shared<FastCgiClient>()),
+              php_(std::make_shared<System::PhpInterpreter>()), projects_(projects), threadCount_(0) {
+        setThreadCount(threadCount);
+        setupShards();
+    }
+
+    WebServer::~WebServer() {
+        stop();
+    }
+
+    WebServer::Shard::~Shard() {
+        // Acceptors have to go before the io_context they are bound to
+        acceptors.clear();
+        ownContext.reset();
     }
 
 // Start the server
     void WebServer::start() {
         if (!running_) {
             running_ = true;
-            // Start io_context in a separate thread
-            ioThread_ = std::make_unique<std::thread>([this]() {
-                try {
-                    ioContext_.run();
-                    Debug::Log::info("IO context stopped", "WebServer");
-                } catch (const std::exception& e) {
-                    Debug::Log::error(std::format("IO context error: {}", e.what()), "WebServer");
+            watcher_->start();
+            if (sharded_) {
+                // One thread per shard, each running only its own io_context
+                for (std::size_t i = 0; i < shards_.size(); ++i) {
+                    ioThreads_.emplace_back([this, i, context = shards_[i]->ioContext]() {
+                        try {
+                            context->run();
+                            Debug::Log::info(std::format("IO shard {} stopped", i), "WebServer");
+                        } catch (const std::exception& e) {
+                            Debug::Log::error(std::format("IO shard {} error: {}", i, e.what()), "WebServer");
+                        }
+                    });
+                }
+            } else {
+                // Run io_context on every worker thread of the pool
+                for (std::size_t i = 0; i < threadCount_; ++i) {
+                    ioThreads_.emplace_back([this, i]() {
+                        try {
+                            ioContext_.run();
+                            Debug::Log::info(std::format("IO worker {} stopped", i), "WebServer");
+                        } catch (const std::exception& e) {
+                            Debug::Log::error(std::format("IO worker {} error: {}", i, e.what()), "WebServer");
+                        }
+                    });
                 }
-            });
-            Debug::Log::info(std::format("Server started with {} projects", projects_.size()), "WebServer");
+            }
+            Debug::Log::info(std::format("Server started with {} projects on {} worker threads ({})",
+                                         projects_.size(), ioThreads_.size(), sharded_ ? "sharded" : "shared io_context"), "WebServer");
         }
     }
 
@@ -31,66 +67,200 @@ namespace Network {
     void WebServer::stop() {
         if (running_) {
             running_ = false;
-            for (auto& acceptor : acceptors_) {
-                if (acceptor->is_open()) {
-                    boost::system::error_code ec;
-                    acceptor->close(ec);
-                    if (ec) {
-                        Debug::Log::error(std::format("Error closing acceptor: {}", ec.message()), "WebServer");
+            for (auto& shard : shards_) {
+                for (auto& acceptor : shard->acceptors) {
+                    if (acceptor->is_open()) {
+                        boost::system::error_code ec;
+                        acceptor->close(ec);
+                        if (ec) {
+                            Debug::Log::error(std::format("Error closing acceptor: {}", ec.message()), "WebServer");
+                        }
                     }
                 }
+                shard->ioContext->stop();
             }
-            ioContext_.stop();
-            if (ioThread_ && ioThread_->joinable()) {
-                ioThread_->join();
+            for (auto& thread : ioThreads_) {
+                if (thread.joinable()) {
+                    thread.join();
+                }
             }
+            ioThreads_.clear();
+            watcher_->stop();
             ioContext_.restart(); // Prepare io_context for next start
-            acceptors_.clear();
-            handlers_.clear();
-            for (const auto& [port, path] : projects_) {
-                startAccept(port, path); // Reinitialize acceptors for restart
-            }
+            fileCache_->clear(); // Files may change while stopped
+            setupShards(); // Reinitialize acceptors for restart
             Debug::Log::info("Server stopped", "WebServer");
         }
     }
 
+// (Re)create shards, handlers and acceptors for the current mode
+    void WebServer::setupShards() {
+        watcher_ = std::make_unique<System::DirectoryWatcher>();
+        shards_.clear();
+        handlers_.clear();
+        std::size_t shardCount = sharded_ ? threadCount_ : 1;
+        for (std::size_t i = 0; i < shardCount; ++i) {
+            auto shard = std::make_unique<Shard>();
+            if (sharded_) {
+                shard->ownContext = std::make_unique<boost::asio::io_context>(1);
+                shard->ioContext = shard->ownContext.get();
+            } else {
+                shard->ioContext = &ioContext_;
+            }
+            shards_.push_back(std::move(shard));
+        }
+        for (const auto& [port, path] : projects_) {
+            startAccept(port, path);
+        }
+    }
+
 // Start accepting connections on a specific port
     void WebServer::startAccept(int port, const std::string& rootDir) {
-        try {
-            auto acceptor = std::make_unique<boost::asio::ip::tcp::acceptor>(
-                    ioContext_, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), port));
-            auto handler = std::make_shared<RequestHandler>(ioContext_, rootDir);
-
-            // Start asynchronous accept loop
-            doAccept(acceptor.get(), handler, port, rootDir);
-
-            acceptors_.push_back(std::move(acceptor));
-            handlers_.push_back(std::move(handler));
-            Debug::Log::info(std::format("Started acceptor on port {}", port), "WebServer");
-        } catch (const std::exception& e) {
-            Debug::Log::error(std::format("Failed to start acceptor on port {}: {}", port, e.what()), "WebServer");
+        auto handler = std::make_shared<RequestHandler>(ioContext_, rootDir, fileCache_, compressor_, fastCgiClient_, php_);
+        boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::tcp::v4(), port);
+        for (auto& shard : shards_) {
+            try {
+                auto acceptor = std::make_unique<boost::asio::ip::tcp::acceptor>(*shard->ioContext);
+                acceptor->open(endpoint.protocol());
+                acceptor->set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+#ifdef SO_REUSEPORT
+                if (sharded_) {
+                    acceptor->set_option(ReusePort(true));
+                }
+#endif
+                acceptor->bind(endpoint);
+                acceptor->listen();
+
+                // Start asynchronous accept loop
+                doAccept(shard.get(), acceptor.get(), handler, port, rootDir);
+
+                shard->acceptors.push_back(std::move(acceptor));
+            } catch (const std::exception& e) {
+                Debug::Log::error(std::format("Failed to start acceptor on port {}: {}", port, e.what()), "WebServer");
+                return;
+            }
         }
+        watcher_->watch(rootDir, [handler](const std::filesystem::path& path, bool subtree) {
+            handler->onFileChanged(path, subtree);
+        });
+        handlers_.push_back(std::move(handler));
+        Debug::Log::info(std::format("Started {} acceptor(s) on port {}", shards_.size(), port), "WebServer");
     }
 
 // Handle asynchronous accept operations
-    void WebServer::doAccept(boost::asio::ip::tcp::acceptor* acceptor, std::shared_ptr<RequestHandler> handler,
+    void WebServer::doAccept(Shard* shard, boost::asio::ip::tcp::acceptor* acceptor, std::shared_ptr<RequestHandler> handler,
                              int port, const std::string& rootDir) {
-        auto socket = std::make_shared<boost::asio::ip::tcp::socket>(ioContext_);
-        Debug::Log::info(std::format("Starting async_accept on port {}", port), "WebServer");
-        acceptor->async_accept(*socket, [this, acceptor, handler, port, rootDir, socket](const boost::system::error_code& error) {
+        auto socket = std::make_shared<boost::asio::ip::tcp::socket>(*shard->ioContext);
+        LOG_DEBUG("WebServer", "Starting async_accept on port {}", port);
+        acceptor->async_accept(*socket, [this, shard, acceptor, handler, port, rootDir, socket](const boost::system::error_code& error) {
+            if (error == boost::asio::error::operation_aborted) {
+                return; // Acceptor closed by stop()
+            }
             if (!error) {
-                Debug::Log::info(std::format("Accepted connection on port {}", port), "WebServer");
-                // Process request in a separate thread
-                std::thread(&RequestHandler::handleRequest, handler, socket).detach();
+                LOG_DEBUG("WebServer", "Accepted connection on port {}", port);
+                ++shard->counters->connections;
+                dispatch(shard, handler, socket);
             } else if (running_) {
                 Debug::Log::error(std::format("Accept error on port {}: {}", port, error.message()), "WebServer");
             }
             // Continue accepting connections if server is running
             if (running_) {
-                Debug::Log::info(std::format("Preparing next async_accept on port {}", port), "WebServer");
-                doAccept(acceptor, handler, port, rootDir);
+                LOG_DEBUG("WebServer", "Preparing next async_accept on port {}", port);
+                doAccept(shard, acceptor, handler, port, rootDir);
             }
         });
     }
 
+// Set the worker pool size used by the next start()
+    void WebServer::setThreadCount(std::size_t threadCount) {
+        if (running_) {
+            Debug::Log::warn("Worker pool size can only be changed while the server is stopped", "WebServer");
+            return;
+        }
+        std::size_t previous = threadCount_;
+        threadCount_ = threadCount != 0 ? threadCount : std::max(1u, std::thread::hardware_concurrency());
+        if (sharded_ && previous != threadCount_) {
+            setupShards();
+        }
+    }
+
+// Switch between one shared io_context and one io_context per worker
+    void WebServer::setSharded(bool sharded) {
+        if (running_) {
+            Debug::Log::warn("Sharding can only be changed while the server is stopped", "WebServer");
+            return;
+        }
+#ifndef SO_REUSEPORT
+        if (sharded) {
+            Debug::Log::warn("SO_REUSEPORT is not available on this platform, sharding disabled", "WebServer");
+            sharded = false;
+        }
+#endif
+        if (sharded_ != sharded) {
+            sharded_ = sharded;
+            setupShards();
+        }
+    }
+
+// Hand an accepted connection to the worker pool
+    void WebServer::dispatch(Shard* shard, std::shared_ptr<RequestHandler> handler, std::shared_ptr<boost::asio::ip::tcp::socket> socket) {
+        // The counters are captured by value: stop() replaces the shards while kept-alive connections may live on
+        auto onClose = [counters = counters_]() {
+            --counters->active;
+            ++counters->completed;
+        };
+        auto onRequest = [counters = shard->counters]() {
+            ++counters->requests;
+        };
+        if (sharded_) {
+            // Already on the shard's own thread, the connection never leaves it
+            ++counters_->active;
+            handler->handleRequest(socket, onClose, onRequest);
+            return;
+        }
+        ++counters_->queued;
+        boost::asio::post(ioContext_, [counters = counters_, handler, socket, onClose, onRequest]() {
+            --counters->queued;
+            ++counters->active;
+            // The connection runs asynchronously on the pool, counters settle when it closes
+            handler->handleRequest(socket, onClose, onRequest);
+        });
+    }
+
+// Get a snapshot of the worker pool counters
+    WebServer::PoolStats WebServer::getPoolStats() const {
+        PoolStats stats;
+        stats.threads = ioThreads_.size();
+        stats.queued = counters_->queued.load();
+        stats.active = counters_->active.load();
+        stats.completed = counters_->completed.load();
+        return stats;
+    }
+
+// Get a snapshot of the per-shard counters
+    std::vector<WebServer::ShardStats> WebServer::getShardStats() const {
+        std::vector<ShardStats> stats;
+        stats.reserve(shards_.size());
+        for (const auto& shard : shards_) {
+            stats.push_back({shard->counters->connections.load(), shard->counters->requests.load()});
+        }
+        return stats;
+    }
+
+// Get the PHP microcache counters summed over all projects
+    MicroCache::Stats WebServer::getMicroCacheStats() const {
+        MicroCache::Stats stats;
+        for (const auto& handler : handlers_) {
+            MicroCache::Stats project = handler->getMicroCacheStats();
+            stats.hits += project.hits;
+            stats.misses += project.misses;
+            stats.stale += project.stale;
+            stats.coalesced += project.coalesced;
+            stats.evictions += project.evictions;
+            stats.entries += project.entries;
+            stats.bytes += project.bytes;
+        }
+        return stats;
+    }
+
 } // namespace Network
\ No newline at end of file
@@ -2,16 +2,36 @@
 #define WEBSERVER_H
 
 #include <boost/asio.hpp>
+#include <atomic>
+#include <cstdint>
 #include <vector>
 #include <memory>
 #include <thread>
 #include "RequestHandler.h"
+#include "../System/DirectoryWatcher.h"
 
 namespace Network {
 
     class WebServer {
     public:
-        WebServer(boost::asio::io_context& ioContext, const std::vector<std::pair<int, std::string>>& projects);
+        // Snapshot of the worker pool counters
+        struct PoolStats {
+            std::size_t threads = 0;       // Worker threads running an io_context
+            std::uint64_t queued = 0;      // Connections posted to the pool but not yet picked up
+            std::uint64_t active = 0;      // Connections currently open
+            std::uint64_t completed = 0;   // Connections finished since start
+        };
+
+        // Snapshot of the counters of one shard
+        struct ShardStats {
+            std::uint64_t connections = 0; // Connections accepted by this shard
+            std::uint64_t requests = 0;    // Requests answered by this shard
+        };
+
+        // threadCount == 0 selects std::thread::hardware_concurrency()
+        WebServer(boost::asio::io_context& ioContext, const std::vector<std::pair<int, std::string>>& projects,
+                  std::size_t threadCount = 0);
+        ~WebServer();
 
         // Start the server
         void start();
@@ -25,20 +45,80 @@ namespace Network {
         // Get list of projects
         const std::vector<std::pair<int, std::string>>& getProjects() const { return projects_; }
 
+        // Set the worker pool size used by the next start(), 0 selects hardware concurrency
+        void setThreadCount(std::size_t threadCount);
+        std::size_t getThreadCount() const { return threadCount_; }
+
+        // Give every worker its own io_context and SO_REUSEPORT acceptors instead of sharing one io_context
+        void setSharded(bool sharded);
+        bool isSharded() const { return sharded_; }
+
+        // Static file cache shared by all projects
+        System::FileCache& getFileCache() { return *fileCache_; }
+
+        // PHP binary located at startup, shared by all projects
+        System::PhpInterpreter& getPhpInterpreter() { return *php_; }
+
+        // Get a snapshot of the worker pool counters
+        PoolStats getPoolStats() const;
+
+        // Get a snapshot of the per-shard counters, a single entry when not sharded
+        std::vector<ShardStats> getShardStats() const;
+
+        // Get the PHP microcache counters summed over all projects
+        MicroCache::Stats getMicroCacheStats() const;
+
     private:
+        // One io_context with its acceptors. Not sharded: a single shard on the shared io_context run by
+        // the whole pool. Sharded: one shard per worker thread, each owning its io_context.
+        // Counters updated by connections, shared with them since a kept-alive connection can outlive its shard
+        struct ShardCounters {
+            std::atomic<std::uint64_t> connections = 0;
+            std::atomic<std::uint64_t> requests = 0;
+        };
+
+        struct PoolCounters {
+            std::atomic<std::uint64_t> queued = 0;
+            std::atomic<std::uint64_t> active = 0;
+            std::atomic<std::uint64_t> completed = 0;
+        };
+
+        struct Shard {
+            std::shared_ptr<ShardCounters> counters = std::make_shared<ShardCounters>();
+            boost::asio::io_context* ioContext = nullptr;
+            std::unique_ptr<boost::asio::io_context> ownContext;
+            std::vector<std::unique_ptr<boost::asio::ip::tcp::acceptor>> acceptors;
+
+            ~Shard();
+        };
+
+        // (Re)create shards, handlers and acceptors for the current mode
+        void setupShards();
+
         // Start accepting connections on a specific port
         void startAccept(int port, const std::string& rootDir);
 
         // Handle asynchronous accept operations
-        void doAccept(boost::asio::ip::tcp::acceptor* acceptor, std::shared_ptr<RequestHandler> handler,
+        void doAccept(Shard* shard, boost::asio::ip::tcp::acceptor* acceptor, std::shared_ptr<RequestHandler> handler,
                       int port, const std::string& rootDir);
 
+        // Hand an accepted connection to the worker pool
+        void dispatch(Shard* shard, std::shared_ptr<RequestHandler> handler, std::shared_ptr<boost::asio::ip::tcp::socket> socket);
+
         boost::asio::io_context& ioContext_;
-        std::vector<std::unique_ptr<boost::asio::ip::tcp::acceptor>> acceptors_;
         std::vector<std::shared_ptr<RequestHandler>> handlers_;
+        std::shared_ptr<System::FileCache> fileCache_;
+        std::shared_ptr<Compressor> compressor_; // Compression threads shared by all projects
+        std::shared_ptr<FastCgiClient> fastCgiClient_; // Connections to external FastCGI servers shared by all projects
+        std::shared_ptr<System::PhpInterpreter> php_; // Located PHP binary, probed once at startup
+        std::unique_ptr<System::DirectoryWatcher> watcher_; // Invalidates cached files of the project roots
         std::vector<std::pair<int, std::string>> projects_;
-        bool running_ = false;
-        std::unique_ptr<std::thread> ioThread_; // Thread for running io_context
+        std::atomic<bool> running_ = false;
+        std::size_t threadCount_;
+        bool sharded_ = false;
+        std::vector<std::unique_ptr<Shard>> shards_;
+        std::vector<std::thread> ioThreads_; // Worker threads running the shards' io_contexts
+        std::shared_ptr<PoolCounters> counters_ = std::make_shared<PoolCounters>(); // Also held by open connections
     };
 
 } // namespace Network
@@ -0,0 +1,42 @@
+#include "Clock.h"
+
+#include "../Network/HttpDate.h"
+
+namespace System {
+
+    std::atomic<std::shared_ptr<const Clock::Now>> Clock::now_;
+    std::atomic<std::time_t> Clock::claimed_{0};
+
+    std::shared_ptr<const Clock::Now> Clock::now() {
+        std::time_t time = std::time(nullptr);
+        std::shared_ptr<const Now> current = now_.load(std::memory_order_acquire);
+        if (current && current->time == time) return current;
+
+        // One thread formats the new second, the others keep using the previous one meanwhile
+        std::time_t claimed = claimed_.load(std::memory_order_relaxed);
+        if (claimed != time && claimed_.compare_exchange_strong(claimed, time, std::memory_order_relaxed)) {
+            current = format(time);
+            now_.store(current, std::memory_order_release);
+            return current;
+        }
+        return current ? current : format(time);
+    }
+
+    std::shared_ptr<const Clock::Now> Clock::format(std::time_t time) {
+        auto now = std::make_shared<Now>();
+        now->time = time;
+        now->httpDate = Network::HttpDate::format(time);
+
+        std::tm local{};
+#ifdef _WIN32
+        localtime_s(&local, &time);
+#else
+        localtime_r(&time, &local);
+#endif
+        char buffer[32];
+        std::size_t length = std::strftime(buffer, sizeof(buffer), "%a %b %e %H:%M:%S %Y", &local);
+        now->timestamp.assign(buffer, length);
+        return now;
+    }
+
+} // System
\ No newline at end of file
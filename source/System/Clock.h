@@ -0,0 +1,33 @@
+#ifndef WEBSERVER_CLOCK_H
+#define WEBSERVER_CLOCK_H
+
+#include <atomic>
+#include <ctime>
+#include <memory>
+#include <string>
+
+namespace System {
+
+    // Wall clock strings shared by the logger and the response writer. The first caller in a new
+    // second formats them, everyone else reuses that snapshot
+    class Clock {
+    public:
+        struct Now {
+            std::time_t time = 0;
+            std::string httpDate;  // Date header value, e.g. "Sun, 06 Nov 1994 08:49:37 GMT"
+            std::string timestamp; // Local time for log lines, e.g. "Sun Nov  6 08:49:37 1994"
+        };
+
+        // Snapshot of the current second, never null
+        static std::shared_ptr<const Now> now();
+
+    private:
+        static std::shared_ptr<const Now> format(std::time_t time);
+
+        static std::atomic<std::shared_ptr<const Now>> now_;
+        static std::atomic<std::time_t> claimed_; // Second formatted last or being formatted
+    };
+
+} // System
+
+#endif //WEBSERVER_CLOCK_H
\ No newline at end of file
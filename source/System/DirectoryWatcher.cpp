@@ -0,0 +1,145 @@
+#include "DirectoryWatcher.h"
+
+#include "../Debug/Log.h"
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <sys/inotify.h>
+#endif
+
+namespace System {
+#ifdef __linux__
+    namespace {
+        constexpr std::uint32_t watchMask = IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE
+                                            | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+    }
+
+    DirectoryWatcher::DirectoryWatcher() : buffer_(64 * 1024) {
+        fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd_ < 0) {
+            Debug::Log::error(std::format("inotify_init1 failed: {}", std::strerror(errno)), "DirectoryWatcher");
+            return;
+        }
+        descriptor_ = std::make_unique<boost::asio::posix::stream_descriptor>(ioContext_, fd_);
+        doRead(); // Stays pending while stopped, events queue up in the kernel
+    }
+
+    DirectoryWatcher::~DirectoryWatcher() {
+        stop();
+        descriptor_.reset(); // Closes the inotify descriptor
+    }
+
+    void DirectoryWatcher::watch(const std::filesystem::path& root, Callback callback) {
+        if (!descriptor_) {
+            return;
+        }
+        std::lock_guard<std::mutex> guard(mutex_);
+        callbacks_.push_back(std::move(callback));
+        addTree(root, callbacks_.size() - 1);
+        Debug::Log::info(std::format("Watching {} for changes", root.string()), "DirectoryWatcher");
+    }
+
+    void DirectoryWatcher::addTree(const std::filesystem::path& directory, std::size_t callback) {
+        addDirectory(directory, callback);
+        std::error_code ec;
+        for (std::filesystem::recursive_directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+            if (it->is_directory(ec)) {
+                addDirectory(it->path(), callback);
+            }
+        }
+    }
+
+    void DirectoryWatcher::addDirectory(const std::filesystem::path& directory, std::size_t callback) {
+        int wd = inotify_add_watch(fd_, directory.c_str(), watchMask);
+        if (wd < 0) {
+            Debug::Log::error(std::format("Failed to watch {}: {}", directory.string(), std::strerror(errno)), "DirectoryWatcher");
+            return;
+        }
+        watches_[wd] = Watch{directory, callback};
+    }
+
+    void DirectoryWatcher::start() {
+        if (!descriptor_ || thread_.joinable()) {
+            return;
+        }
+        ioContext_.restart();
+        thread_ = std::thread([this]() {
+            try {
+                ioContext_.run();
+            } catch (const std::exception& e) {
+                Debug::Log::error(std::format("Watcher error: {}", e.what()), "DirectoryWatcher");
+            }
+        });
+    }
+
+    void DirectoryWatcher::stop() {
+        ioContext_.stop();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    void DirectoryWatcher::doRead() {
+        descriptor_->async_read_some(boost::asio::buffer(buffer_), [this](const boost::system::error_code& error, std::size_t size) {
+            if (error) {
+                if (error != boost::asio::error::operation_aborted) {
+                    Debug::Log::error(std::format("Error reading inotify events: {}", error.message()), "DirectoryWatcher");
+                }
+                return;
+            }
+            handleEvents(size);
+            doRead();
+        });
+    }
+
+    void DirectoryWatcher::handleEvents(std::size_t size) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        for (std::size_t offset = 0; offset < size;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer_.data() + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Events were lost, every watched tree may have changed
+                Debug::Log::warn("inotify queue overflow, invalidating all watched directories", "DirectoryWatcher");
+                for (const auto& [wd, watch] : watches_) {
+                    callbacks_[watch.callback](watch.directory, true);
+                }
+                continue;
+            }
+            auto it = watches_.find(event->wd);
+            if (it == watches_.end()) {
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                watches_.erase(it); // Directory removed, the kernel dropped the watch
+                continue;
+            }
+
+            const Watch& watch = it->second;
+            bool isDirectory = (event->mask & IN_ISDIR) != 0;
+            std::filesystem::path path = event->len > 0 ? watch.directory / event->name : watch.directory;
+            if (isDirectory && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+                addTree(path, watch.callback); // New subtree, watch it as well
+            }
+            bool subtree = isDirectory || (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF));
+            callbacks_[watch.callback](path, subtree);
+        }
+    }
+#else
+    DirectoryWatcher::DirectoryWatcher() = default;
+
+    DirectoryWatcher::~DirectoryWatcher() = default;
+
+    void DirectoryWatcher::watch(const std::filesystem::path& root, Callback) {
+        Debug::Log::warn(std::format("Change notifications are not supported on this platform, {} is not watched", root.string()),
+                         "DirectoryWatcher");
+    }
+
+    void DirectoryWatcher::start() {
+    }
+
+    void DirectoryWatcher::stop() {
+    }
+#endif
+} // System
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef WEBSERVER_DIRECTORYWATCHER_H
+#define WEBSERVER_DIRECTORYWATCHER_H
+
+#include <boost/asio.hpp>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace System {
+
+    // Reports changes below watched directory trees (inotify on Linux, no-op elsewhere).
+    // Events are delivered on the watcher's own thread between start() and stop().
+    class DirectoryWatcher {
+    public:
+        // path is the changed file, or a directory when a whole subtree appeared or went away
+        using Callback = std::function<void(const std::filesystem::path& path, bool subtree)>;
+
+        DirectoryWatcher();
+        ~DirectoryWatcher();
+
+        DirectoryWatcher(const DirectoryWatcher&) = delete;
+        DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+        // Watch a directory and all its subdirectories
+        void watch(const std::filesystem::path& root, Callback callback);
+
+        // Start or stop delivering events
+        void start();
+        void stop();
+
+    private:
+#ifdef __linux__
+        struct Watch {
+            std::filesystem::path directory;
+            std::size_t callback; // Index into callbacks_
+        };
+
+        // Add watches for a directory and everything below it
+        void addTree(const std::filesystem::path& directory, std::size_t callback);
+        void addDirectory(const std::filesystem::path& directory, std::size_t callback);
+
+        void doRead();
+        void handleEvents(std::size_t size);
+
+        int fd_ = -1;
+        std::unique_ptr<boost::asio::posix::stream_descriptor> descriptor_;
+        std::vector<char> buffer_;
+        std::map<int, Watch> watches_; // inotify watch descriptor -> directory
+#endif
+        boost::asio::io_context ioContext_;
+        std::thread thread_;
+        std::mutex mutex_;
+        std::vector<Callback> callbacks_;
+    };
+
+} // System
+
+#endif //WEBSERVER_DIRECTORYWATCHER_H
\ No newline at end of file
@@ -0,0 +1,270 @@
+#include "FileCache.h"
+
+#include "../Debug/Log.h"
+#include "../Network/ContentEncoding.h"
+#include "../Network/HttpDate.h"
+#include <bit>
+#include <fstream>
+#include <functional>
+#include <iterator>
+
+namespace System {
+    FileCache::FileCache(std::size_t byteBudget, std::size_t maxEntrySize)
+            : byteBudget_(byteBudget), maxEntrySize_(maxEntrySize) {
+    }
+
+    namespace {
+        bool isBelow(const std::string& path, const std::string& directory) {
+            return path.starts_with(directory)
+                   && (path.size() == directory.size() || directory.ends_with('/') || directory.ends_with('\\')
+                       || path[directory.size()] == '/' || path[directory.size()] == '\\');
+        }
+    }
+
+    FileCache::Segment& FileCache::segmentFor(const std::string& path) {
+        return segments_[std::hash<std::string>{}(path) % segmentCount];
+    }
+
+    std::shared_ptr<const FileCache::Entry> FileCache::find(const std::string& path) {
+        Segment& segment = segmentFor(path);
+        std::lock_guard<std::mutex> guard(segment.mutex);
+        auto it = segment.index.find(path);
+        if (it == segment.index.end()) {
+            ++segment.misses;
+            return nullptr;
+        }
+        ++segment.hits;
+        segment.lru.splice(segment.lru.begin(), segment.lru, it->second);
+        return *it->second;
+    }
+
+    std::shared_ptr<const FileCache::Entry> FileCache::load(const std::string& path, const std::string& contentType,
+                                                            const std::string& extraHeaders) {
+        // A change notification arriving between reading and storing must not leave the old bytes cached
+        Segment& segment = segmentFor(path);
+        std::uint64_t generation;
+        {
+            std::lock_guard<std::mutex> guard(segment.mutex);
+            generation = segment.generation;
+        }
+
+        std::error_code ec;
+        std::uint64_t size = std::filesystem::file_size(path, ec);
+        if (ec || size > maxEntrySize_) {
+            return nullptr;
+        }
+        auto modified = std::filesystem::last_write_time(path, ec);
+        std::ifstream file(path, std::ios::binary);
+        if (ec || !file) {
+            return nullptr;
+        }
+
+        auto entry = std::make_shared<Entry>();
+        entry->path = path;
+        std::string body;
+        body.reserve(size);
+        body.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        entry->size = body.size();
+        entry->modified = modified;
+        entry->etag = entityTag(entry->size, modified);
+        entry->lastModified = Network::HttpDate::fromFileTime(modified);
+        entry->headers = buildHeaders(*entry, contentType, extraHeaders);
+        entry->body = std::make_shared<const std::string>(std::move(body));
+
+        std::lock_guard<std::mutex> guard(segment.mutex);
+        if (segment.generation != generation) {
+            return nullptr; // Invalidated meanwhile, the caller reads the file again
+        }
+        if (auto it = segment.index.find(path); it != segment.index.end()) {
+            // Loaded concurrently by another request, replace it with the fresh copy
+            segment.bytes -= footprint(**it->second);
+            segment.lru.erase(it->second);
+            segment.index.erase(it);
+        }
+        segment.lru.push_front(entry);
+        segment.index[path] = segment.lru.begin();
+        segment.bytes += entry->size;
+        evict(segment);
+        return entry;
+    }
+
+    std::shared_ptr<const FileCache::Entry> FileCache::findCompressed(const Entry& entry, unsigned coding, bool& claimed) {
+        Segment& segment = segmentFor(entry.path);
+        std::lock_guard<std::mutex> guard(segment.mutex);
+        std::size_t slot = std::countr_zero(coding);
+        claimed = false;
+        if (!entry.compressed[slot] && !(entry.compressing & coding)) {
+            entry.compressing |= coding;
+            claimed = true;
+        }
+        return entry.compressed[slot];
+    }
+
+    void FileCache::storeCompressed(const Entry& entry, unsigned coding, std::shared_ptr<const Entry> variant) {
+        Segment& segment = segmentFor(entry.path);
+        std::lock_guard<std::mutex> guard(segment.mutex);
+        entry.compressing &= ~coding;
+        auto it = segment.index.find(entry.path);
+        if (it == segment.index.end() || it->second->get() != &entry) {
+            return; // The file changed while it was compressed
+        }
+        if (!variant) {
+            auto identity = std::make_shared<Entry>();
+            identity->path = entry.path;
+            identity->body = entry.body;
+            identity->headers = entry.headers;
+            identity->size = entry.size;
+            identity->modified = entry.modified;
+            identity->etag = entry.etag;
+            identity->lastModified = entry.lastModified;
+            variant = std::move(identity);
+        }
+        segment.bytes -= footprint(entry);
+        entry.compressed[std::countr_zero(coding)] = std::move(variant);
+        segment.bytes += footprint(entry);
+        evict(segment);
+    }
+
+    std::shared_ptr<const FileCache::Entry> FileCache::makeVariant(const Entry& entry, std::string body, std::string_view tagSuffix,
+                                                                   const std::string& contentType, const std::string& extraHeaders) {
+        auto variant = std::make_shared<Entry>();
+        variant->path = entry.path;
+        variant->size = body.size();
+        variant->modified = entry.modified;
+        variant->lastModified = entry.lastModified;
+        variant->etag = entry.etag;
+        variant->etag.insert(variant->etag.size() - 1, tagSuffix);
+        variant->headers = buildHeaders(*variant, contentType, extraHeaders);
+        variant->body = std::make_shared<const std::string>(std::move(body));
+        return variant;
+    }
+
+    std::size_t FileCache::footprint(const Entry& entry) {
+        std::size_t bytes = entry.size;
+        for (const auto& variant : entry.compressed) {
+            if (variant && variant->body != entry.body) bytes += variant->size;
+        }
+        return bytes;
+    }
+
+    std::shared_ptr<const std::string> FileCache::buildHeaders(const Entry& entry, const std::string& contentType,
+                                                                const std::string& extraHeaders) {
+        return std::make_shared<const std::string>(
+                std::format("Content-Type: {}\r\nContent-Length: {}\r\nAccept-Ranges: bytes\r\nETag: {}\r\nLast-Modified: {}\r\n{}", contentType,
+                            entry.size, entry.etag, Network::HttpDate::format(entry.lastModified), extraHeaders));
+    }
+
+    std::string FileCache::entityTag(std::uint64_t size, std::filesystem::file_time_type modified) {
+        return std::format("\"{:x}-{:x}\"", size, static_cast<std::uint64_t>(modified.time_since_epoch().count()));
+    }
+
+    unsigned FileCache::precompressed(const std::string& path) {
+        Segment& segment = segmentFor(path);
+        {
+            std::lock_guard<std::mutex> guard(segment.mutex);
+            if (auto it = segment.sidecars.find(path); it != segment.sidecars.end()) {
+                return it->second;
+            }
+        }
+
+        // Only remembered for files that exist, so requests for missing paths cannot grow the map
+        std::error_code ec;
+        if (!std::filesystem::is_regular_file(path, ec)) {
+            return 0;
+        }
+        unsigned codings = 0;
+        for (auto coding : {Network::ContentEncoding::Brotli, Network::ContentEncoding::Gzip}) {
+            if (std::filesystem::is_regular_file(path + std::string(Network::ContentEncoding::sidecarExtension(coding)), ec)) {
+                codings |= coding;
+            }
+        }
+        std::lock_guard<std::mutex> guard(segment.mutex);
+        segment.sidecars[path] = codings;
+        return codings;
+    }
+
+    void FileCache::erase(const std::string& path) {
+        Segment& segment = segmentFor(path);
+        std::lock_guard<std::mutex> guard(segment.mutex);
+        ++segment.generation;
+        if (auto it = segment.index.find(path); it != segment.index.end()) {
+            segment.bytes -= footprint(**it->second);
+            segment.lru.erase(it->second);
+            segment.index.erase(it);
+        }
+        segment.sidecars.erase(path);
+    }
+
+    void FileCache::invalidate(const std::string& path) {
+        erase(path);
+        // A sidecar that appears or changes alters the Vary header and the sidecar set of its file
+        for (auto coding : {Network::ContentEncoding::Brotli, Network::ContentEncoding::Gzip}) {
+            std::string_view extension = Network::ContentEncoding::sidecarExtension(coding);
+            if (path.size() > extension.size() && path.ends_with(extension)) {
+                erase(path.substr(0, path.size() - extension.size()));
+            }
+        }
+    }
+
+    void FileCache::invalidatePrefix(const std::string& directory) {
+        for (auto& segment : segments_) {
+            std::lock_guard<std::mutex> guard(segment.mutex);
+            ++segment.generation;
+            for (auto it = segment.lru.begin(); it != segment.lru.end();) {
+                if (isBelow((*it)->path, directory)) {
+                    segment.bytes -= footprint(**it);
+                    segment.index.erase((*it)->path);
+                    it = segment.lru.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            std::erase_if(segment.sidecars, [&](const auto& item) { return isBelow(item.first, directory); });
+        }
+    }
+
+    void FileCache::clear() {
+        for (auto& segment : segments_) {
+            std::lock_guard<std::mutex> guard(segment.mutex);
+            ++segment.generation;
+            segment.lru.clear();
+            segment.index.clear();
+            segment.sidecars.clear();
+            segment.bytes = 0;
+        }
+    }
+
+    void FileCache::setByteBudget(std::size_t byteBudget) {
+        byteBudget_ = byteBudget;
+        for (auto& segment : segments_) {
+            std::lock_guard<std::mutex> guard(segment.mutex);
+            evict(segment);
+        }
+        Debug::Log::info(std::format("File cache budget set to {} bytes", byteBudget), "FileCache");
+    }
+
+    void FileCache::evict(Segment& segment) {
+        std::size_t segmentBudget = byteBudget_ / segmentCount;
+        while (segment.bytes > segmentBudget && !segment.lru.empty()) {
+            const auto& entry = segment.lru.back();
+            segment.bytes -= footprint(*entry);
+            segment.index.erase(entry->path);
+            segment.lru.pop_back();
+            ++segment.evictions;
+        }
+    }
+
+    FileCache::Stats FileCache::getStats() const {
+        Stats stats;
+        stats.byteBudget = byteBudget_;
+        for (const auto& segment : segments_) {
+            std::lock_guard<std::mutex> guard(segment.mutex);
+            stats.hits += segment.hits;
+            stats.misses += segment.misses;
+            stats.evictions += segment.evictions;
+            stats.entries += segment.index.size();
+            stats.bytes += segment.bytes;
+        }
+        return stats;
+    }
+} // System
\ No newline at end of file
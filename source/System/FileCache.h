@@ -0,0 +1,125 @@
+#ifndef WEBSERVER_FILECACHE_H
+#define WEBSERVER_FILECACHE_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace System {
+
+    // In-memory cache of static files keyed by resolved path, shared by all projects.
+    // Split into independently locked segments, each evicting least recently used entries
+    // once its share of the byte budget is exceeded.
+    class FileCache {
+    public:
+        struct Entry {
+            std::string path;                           // Resolved file path (cache key)
+            std::shared_ptr<const std::string> body;    // File content
+            std::shared_ptr<const std::string> headers; // Pre-built Content-Type/Content-Length/Accept-Ranges/ETag/Last-Modified lines
+            std::uint64_t size = 0;
+            std::filesystem::file_time_type modified;
+            std::string etag;               // Strong validator derived from size and modification time
+            std::time_t lastModified = 0;   // Modification time in whole seconds, as sent in Last-Modified
+
+            // Bodies compressed on the fly, by coding bit, guarded by the segment lock
+            mutable std::array<std::shared_ptr<const Entry>, 4> compressed;
+            mutable unsigned compressing = 0; // Codings some request is producing right now
+        };
+
+        struct Stats {
+            std::uint64_t hits = 0;
+            std::uint64_t misses = 0;
+            std::uint64_t evictions = 0;
+            std::size_t entries = 0;
+            std::size_t bytes = 0;
+            std::size_t byteBudget = 0;
+        };
+
+        explicit FileCache(std::size_t byteBudget = 64 * 1024 * 1024, std::size_t maxEntrySize = 1024 * 1024);
+
+        // Look up a file, counts a hit or a miss
+        std::shared_ptr<const Entry> find(const std::string& path);
+
+        // Read a file and cache it, empty if it cannot be read, is larger than maxEntrySize or was
+        // invalidated while it was read. extraHeaders (complete header lines) are appended to the pre-built header block
+        std::shared_ptr<const Entry> load(const std::string& path, const std::string& contentType,
+                                          const std::string& extraHeaders = std::string());
+
+        // Compressed variant of a cached file. When there is none yet and nobody is producing it,
+        // claimed is set and the caller is expected to call storeCompressed()
+        std::shared_ptr<const Entry> findCompressed(const Entry& entry, unsigned coding, bool& claimed);
+
+        // Attach a compressed variant (made with makeVariant), counted against the byte budget.
+        // Null records that compression does not pay off, later lookups get an entry sharing the
+        // uncompressed body. Dropped if the file was invalidated meanwhile
+        void storeCompressed(const Entry& entry, unsigned coding, std::shared_ptr<const Entry> variant);
+
+        // Entry for a transformed body of a cached file with its own entity tag (tag suffix appended)
+        static std::shared_ptr<const Entry> makeVariant(const Entry& entry, std::string body, std::string_view tagSuffix,
+                                                        const std::string& contentType, const std::string& extraHeaders);
+
+        // Precompressed sidecars (file.br, file.gz) present next to an existing file as a
+        // Network::ContentEncoding set, looked up on disk once and remembered until invalidated
+        unsigned precompressed(const std::string& path);
+
+        // Drop one file, or every file below a directory. Dropping a sidecar also drops the file it belongs to
+        void invalidate(const std::string& path);
+        void invalidatePrefix(const std::string& directory);
+        void clear();
+
+        // Change the byte budget, evicting entries if it shrinks
+        void setByteBudget(std::size_t byteBudget);
+
+        std::size_t getMaxEntrySize() const { return maxEntrySize_; }
+
+        // Entity tag for a file version, also used for files too large to cache
+        static std::string entityTag(std::uint64_t size, std::filesystem::file_time_type modified);
+
+        Stats getStats() const;
+
+    private:
+        static constexpr std::size_t segmentCount = 8;
+
+        struct Segment {
+            mutable std::mutex mutex;
+            std::list<std::shared_ptr<const Entry>> lru; // Most recently used first
+            std::unordered_map<std::string, std::list<std::shared_ptr<const Entry>>::iterator> index;
+            std::unordered_map<std::string, unsigned> sidecars; // Result of precompressed() per file
+            std::size_t bytes = 0;
+            std::uint64_t generation = 0; // Bumped by every invalidation, a load that saw another value is not stored
+            std::uint64_t hits = 0;
+            std::uint64_t misses = 0;
+            std::uint64_t evictions = 0;
+        };
+
+        Segment& segmentFor(const std::string& path);
+
+        // Bytes held by an entry including its compressed variants, under the segment lock
+        static std::size_t footprint(const Entry& entry);
+
+        // Pre-built header block of an entry
+        static std::shared_ptr<const std::string> buildHeaders(const Entry& entry, const std::string& contentType,
+                                                               const std::string& extraHeaders);
+
+        // Drop one file and its sidecar set
+        void erase(const std::string& path);
+
+        // Evict from the back of the segment until it fits its share of the budget
+        void evict(Segment& segment);
+
+        std::array<Segment, segmentCount> segments_;
+        std::atomic<std::size_t> byteBudget_;
+        std::size_t maxEntrySize_;
+    };
+
+} // System
+
+#endif //WEBSERVER_FILECACHE_H
\ No newline at end of file
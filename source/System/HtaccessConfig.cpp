@@ -37,6 +37,132 @@ namespace System {
                 } else {
                     Debug::Log::error(std::format("Invalid port in .htaccess: {}", line), "HtaccessConfig");
                 }
+            } else if (directive == "KeepAlive") {
+                std::string value;
+                if (ss >> value && (value == "On" || value == "Off")) {
+                    config.keepAlive = value == "On";
+                    Debug::Log::info(std::format("Parsed KeepAlive {} from .htaccess: {}", value, filePath), "HtaccessConfig");
+                } else {
+                    Debug::Log::error(std::format("Invalid KeepAlive in .htaccess: {}", line), "HtaccessConfig");
+                }
+            } else if (directive == "MaxKeepAliveRequests") {
+                int requests;
+                if (ss >> requests && requests > 0) {
+                    config.maxKeepAliveRequests = requests;
+                    Debug::Log::info(std::format("Parsed MaxKeepAliveRequests {} from .htaccess: {}", requests, filePath), "HtaccessConfig");
+                } else {
+                    Debug::Log::error(std::format("Invalid MaxKeepAliveRequests in .htaccess: {}", line), "HtaccessConfig");
+                }
+            } else if (directive == "KeepAliveTimeout") {
+                int seconds;
+                if (ss >> seconds && seconds > 0) {
+                    config.keepAliveTimeout = seconds;
+                    Debug::Log::info(std::format("Parsed KeepAliveTimeout {} from .htaccess: {}", seconds, filePath), "HtaccessConfig");
+                } else {
+                    Debug::Log::error(std::format("Invalid KeepAliveTimeout in .htaccess: {}", line), "HtaccessConfig");
+                }
+            } else if (directive == "LimitRequestBody") {
+                std::size_t size;
+                if (ss >> size) {
+                    config.limitRequestBody = size;
+                    Debug::Log::info(std::format("Parsed LimitRequestBody {} from .htaccess: {}", size, filePath), "HtaccessConfig");
+                } else {
+                    Debug::Log::error(std::format("Invalid LimitRequestBody in .htaccess: {}", line), "HtaccessConfig");
+                }
+            } else if (directive == "Compression") {
+                std::string value;
+                if (ss >> value && (value == "On" || value == "Off")) {
+                    config.compression = value == "On";
+                    Debug::Log::info(std::format("Parsed Compression {} from .htaccess: {}", value, filePath), "HtaccessConfig");
+                } else {
+                    Debug::Log::error(std::format("Invalid Compression in .htaccess: {}", line), "HtaccessConfig");
+                }
+            } else if (directive == "CompressionLevel") {
+                int level;
+                if (ss >> level && level >= 1 && level <= 9) {
+                    config.compressionLevel = level;
+                    Debug::Log::info(std::format("Parsed CompressionLevel {} from .htaccess: {}", level, filePath), "HtaccessConfig");
+                } else {
+                    Debug::Log::error(std::format("Invalid CompressionLevel in .htaccess: {}", line), "HtaccessConfig");
+                }
+            } else if (directive == "CompressionMinSize") {
+                std::size_t size;
+                if (ss >> size) {
+                    config.compressionMinSize = size;
+                    Debug::Log::info(std::format("Parsed CompressionMinSize {} from .htaccess: {}", size, filePath), "HtaccessConfig");
+                } else {
+                    Debug::Log::error(std::format("Invalid CompressionMinSize in .htaccess: {}", line), "HtaccessConfig");
+                }
+            } else if (directive == "CompressionTypes") {
+                std::vector<std::string> types;
+                for (std::string type; ss >> type;) {
+                    types.push_back(type);
+                }
+                if (!types.empty()) {
+                    config.compressionTypes = std::move(types);
+                    Debug::Log::info(std::format("Parsed {} CompressionTypes from .htaccess: {}", config.compressionTypes.size(), filePath), "HtaccessConfig");
+                } else {
+                    Debug::Log::error(std::format("Invalid CompressionTypes in .htaccess: {}", line), "HtaccessConfig");
+                }
+            } else if (directive == "PhpWorkers") {
+                int workers;
+                if (ss >> workers && workers >= 0) {
+                    config.phpWorkers = workers;
+                    Debug::Log::info(std::format("Parsed PhpWorkers {} from .htaccess: {}", workers, filePath), "HtaccessConfig");
+                } else {
+                    Debug::Log::error(std::format("Invalid PhpWorkers in .htaccess: {}", line), "HtaccessConfig");
+                }
+            } else if (directive == "PhpMaxRequests") {
+                int requests;
+                if (ss >> requests && requests > 0) {
+                    config.phpMaxRequests = requests;
+                    Debug::Log::info(std::format("Parsed PhpMaxRequests {} from .htaccess: {}", requests, filePath), "HtaccessConfig");
+                } else {
+                    Debug::Log::error(std::format("Invalid PhpMaxRequests in .htaccess: {}", line), "HtaccessConfig");
+                }
+            } else if (directive == "PhpQueueSize") {
+                int size;
+                if (ss >> size && size >= 0) {
+                    config.phpQueueSize = size;
+                    Debug::Log::info(std::format("Parsed PhpQueueSize {} from .htaccess: {}", size, filePath), "HtaccessConfig");
+                } else {
+                    Debug::Log::error(std::format("Invalid PhpQueueSize in .htaccess: {}", line), "HtaccessConfig");
+                }
+            } else if (directive == "PhpFastCgi") {
+                std::string address;
+                if (ss >> address) {
+                    config.phpFastCgi = address;
+                    Debug::Log::info(std::format("Parsed PhpFastCgi {} from .htaccess: {}", address, filePath), "HtaccessConfig");
+                } else {
+                    Debug::Log::error(std::format("Invalid PhpFastCgi in .htaccess: {}", line), "HtaccessConfig");
+                }
+            } else if (directive == "MicroCache") {
+                int seconds;
+                if (ss >> seconds && seconds >= 0) {
+                    config.microCache = seconds;
+                    Debug::Log::info(std::format("Parsed MicroCache {} from .htaccess: {}", seconds, filePath), "HtaccessConfig");
+                } else {
+                    Debug::Log::error(std::format("Invalid MicroCache in .htaccess: {}", line), "HtaccessConfig");
+                }
+            } else if (directive == "MicroCacheStale") {
+                int seconds;
+                if (ss >> seconds && seconds >= 0) {
+                    config.microCacheStale = seconds;
+                    Debug::Log::info(std::format("Parsed MicroCacheStale {} from .htaccess: {}", seconds, filePath), "HtaccessConfig");
+                } else {
+                    Debug::Log::error(std::format("Invalid MicroCacheStale in .htaccess: {}", line), "HtaccessConfig");
+                }
+            } else if (directive == "MicroCacheVary") {
+                std::vector<std::string> headers;
+                for (std::string header; ss >> header;) {
+                    headers.push_back(header);
+                }
+                if (!headers.empty()) {
+                    config.microCacheVary = std::move(headers);
+                    Debug::Log::info(std::format("Parsed {} MicroCacheVary headers from .htaccess: {}", config.microCacheVary.size(), filePath), "HtaccessConfig");
+                } else {
+                    Debug::Log::error(std::format("Invalid MicroCacheVary in .htaccess: {}", line), "HtaccessConfig");
+                }
             } else if (directive == "AddType") {
                 std::string extension, mimeType;
                 if (ss >> extension >> mimeType) {
@@ -50,4 +176,17 @@ namespace System {
 
         return config;
     }
+
+    bool HtaccessConfig::isCompressible(const std::string& contentType) const {
+        // Parameters such as charset do not matter
+        std::string_view type(contentType);
+        type = type.substr(0, type.find(';'));
+        while (!type.empty() && type.back() == ' ') type.remove_suffix(1);
+        for (const auto& pattern : compressionTypes) {
+            if (pattern.ends_with("/*") ? type.starts_with(std::string_view(pattern).substr(0, pattern.size() - 1)) : type == pattern) {
+                return true;
+            }
+        }
+        return false;
+    }
 } // System
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <string>
 #include <optional>
 #include <map>
+#include <vector>
 
 namespace System {
 
@@ -11,6 +12,25 @@ namespace System {
     public:
         std::optional<int> port; // Port number specified in .htaccess
         std::map<std::string, std::string> mimeTypes; // MIME types for file extensions
+        bool keepAlive = true; // Allow persistent HTTP/1.1 connections
+        int maxKeepAliveRequests = 100; // Requests served on one connection before it is closed
+        int keepAliveTimeout = 5; // Seconds to wait for the next request on an idle connection
+        std::size_t limitRequestBody = 8 * 1024 * 1024; // Largest request body accepted, 0 for no limit
+        bool compression = true; // Compress responses on the fly when the client accepts it
+        int compressionLevel = 6; // 1 (fastest) to 9 (smallest)
+        std::size_t compressionMinSize = 1024; // Smaller bodies are sent as they are
+        std::vector<std::string> compressionTypes = {"text/*", "application/javascript", "application/json",
+                                                     "application/xml", "image/svg+xml"}; // "type/*" matches a whole type
+        int phpWorkers = 4; // Persistent php-cgi FastCGI children, 0 starts php-cgi for every request
+        int phpMaxRequests = 500; // Requests a child serves before it is replaced
+        int phpQueueSize = 64; // Requests waiting for a busy pool before 503 is returned
+        std::string phpFastCgi; // External FastCGI server (php-fpm) address, replaces the php-cgi pool when set
+        int microCache = 0; // Seconds PHP responses are cached and shared between requests, 0 disables the microcache
+        int microCacheStale = 0; // Seconds an expired response is still served while one request refreshes it
+        std::vector<std::string> microCacheVary; // Request headers whose values are part of the microcache key
+
+        // Whether a Content-Type value is listed in compressionTypes
+        bool isCompressible(const std::string& contentType) const;
 
         // Parse .htaccess file and return config
         static HtaccessConfig parse(const std::string& filePath);
@@ -0,0 +1,132 @@
+#include "PhpInterpreter.h"
+
+#include "../Debug/Log.h"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace System {
+    namespace {
+        constexpr auto retryInterval = std::chrono::seconds(10);
+    }
+
+    PhpInterpreter::PhpInterpreter(std::string binary) : binary_(std::move(binary)) {
+        info_.store(std::make_shared<const Info>(probe(binary_)));
+        lastProbe_ = std::chrono::steady_clock::now();
+    }
+
+    std::string PhpInterpreter::defaultBinary() {
+#ifdef _WIN32
+        return "php";
+#else
+        return "php-cgi";
+#endif
+    }
+
+    std::shared_ptr<const PhpInterpreter::Info> PhpInterpreter::reprobe(bool force) {
+        std::lock_guard<std::mutex> guard(probeMutex_);
+        auto now = std::chrono::steady_clock::now();
+        if (!force && now - lastProbe_ < retryInterval) {
+            return info_.load();
+        }
+        lastProbe_ = now;
+        auto info = std::make_shared<const Info>(probe(binary_));
+        info_.store(info);
+        return info;
+    }
+
+    PhpInterpreter::Info PhpInterpreter::probe(const std::string& binary) {
+        Info info;
+        info.path = findExecutable(binary);
+        if (info.path.empty()) {
+            Debug::Log::error(std::format("{} not found in PATH", binary), "PhpInterpreter");
+            return info;
+        }
+        info.version = queryVersion(info.path);
+        Debug::Log::info(std::format("Found PHP {} at {}", info.version.empty() ? "(unknown version)" : info.version, info.path),
+                         "PhpInterpreter");
+        return info;
+    }
+
+    std::string PhpInterpreter::findExecutable(const std::string& binary) {
+        auto isExecutable = [](const std::filesystem::path& candidate) {
+            std::error_code ec;
+            if (!std::filesystem::is_regular_file(candidate, ec)) {
+                return false;
+            }
+#ifdef _WIN32
+            return true;
+#else
+            return ::access(candidate.c_str(), X_OK) == 0;
+#endif
+        };
+        auto resolve = [&](const std::filesystem::path& candidate) -> std::string {
+            if (isExecutable(candidate)) {
+                return std::filesystem::absolute(candidate).lexically_normal().string();
+            }
+#ifdef _WIN32
+            if (auto exe = std::filesystem::path(candidate).concat(".exe"); isExecutable(exe)) {
+                return std::filesystem::absolute(exe).lexically_normal().string();
+            }
+#endif
+            return {};
+        };
+
+        // A configured path is used as is, a bare name is searched for like a shell would
+        if (std::filesystem::path(binary).has_parent_path()) {
+            return resolve(binary);
+        }
+        const char* path = std::getenv("PATH");
+        if (!path) {
+            return {};
+        }
+#ifdef _WIN32
+        constexpr char separator = ';';
+#else
+        constexpr char separator = ':';
+#endif
+        std::stringstream directories(path);
+        std::string directory;
+        while (std::getline(directories, directory, separator)) {
+            if (directory.empty()) {
+                continue;
+            }
+            if (auto found = resolve(std::filesystem::path(directory) / binary); !found.empty()) {
+                return found;
+            }
+        }
+        return {};
+    }
+
+    std::string PhpInterpreter::queryVersion(const std::string& path) {
+        // "PHP 8.2.7 (cgi-fcgi) (built: ...)" is the first line of -v
+#ifdef _WIN32
+        std::string command = "\"\"" + path + "\" -v 2>NUL\"";
+        FILE* pipe = _popen(command.c_str(), "r");
+#else
+        std::string command = "'" + path + "' -v 2>/dev/null";
+        FILE* pipe = popen(command.c_str(), "r");
+#endif
+        if (!pipe) {
+            return {};
+        }
+        char buffer[256] = {};
+        bool read = fgets(buffer, sizeof(buffer), pipe) != nullptr;
+#ifdef _WIN32
+        _pclose(pipe);
+#else
+        pclose(pipe);
+#endif
+        std::string name, version;
+        if (read && (std::istringstream(buffer) >> name >> version) && name == "PHP") {
+            return version;
+        }
+        return {};
+    }
+
+} // System
\ No newline at end of file
@@ -0,0 +1,48 @@
+#ifndef WEBSERVER_PHPINTERPRETER_H
+#define WEBSERVER_PHPINTERPRETER_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace System {
+
+    // Locates the PHP binary once (php on Windows, php-cgi elsewhere) and caches its absolute
+    // path and version, so requests do not have to start a shell to check for it
+    class PhpInterpreter {
+    public:
+        struct Info {
+            std::string path;    // Absolute path, empty if the binary was not found
+            std::string version; // e.g. "8.2.7"
+
+            bool isAvailable() const { return !path.empty(); }
+        };
+
+        explicit PhpInterpreter(std::string binary = defaultBinary());
+
+        static std::string defaultBinary();
+
+        // Result of the last probe
+        std::shared_ptr<const Info> get() const { return info_.load(); }
+
+        // Probe again after running PHP failed; unless forced at most once per retry interval
+        std::shared_ptr<const Info> reprobe(bool force = false);
+
+        // Search PATH for binary and ask it for its version
+        static Info probe(const std::string& binary);
+
+    private:
+        static std::string findExecutable(const std::string& binary);
+        static std::string queryVersion(const std::string& path);
+
+        std::string binary_;
+        std::atomic<std::shared_ptr<const Info>> info_;
+        std::mutex probeMutex_;
+        std::chrono::steady_clock::time_point lastProbe_;
+    };
+
+} // System
+
+#endif //WEBSERVER_PHPINTERPRETER_H
\ No newline at end of file
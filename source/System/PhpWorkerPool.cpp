@@ -0,0 +1,238 @@
+#include "PhpWorkerPool.h"
+
+#include "../Debug/Log.h"
+#include <atomic>
+#include <filesystem>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+namespace System {
+    namespace {
+        std::atomic<int> poolCounter{0};
+        constexpr auto startupWindow = std::chrono::seconds(3); // Time a new child gets to bind its socket
+        constexpr auto spawnBackoff = std::chrono::seconds(5);  // Pause after php-cgi could not be started
+        constexpr auto reapInterval = std::chrono::seconds(1);
+    }
+
+    PhpWorkerPool::PhpWorkerPool(Settings settings)
+            : settings_(std::move(settings)), ioContext_(std::make_shared<boost::asio::io_context>()),
+              workGuard_(boost::asio::make_work_guard(*ioContext_)), reapTimer_(*ioContext_) {
+        int pool = poolCounter++;
+        workers_.resize(static_cast<std::size_t>(std::max(1, settings_.workers)));
+        for (std::size_t i = 0; i < workers_.size(); ++i) {
+#ifndef _WIN32
+            workers_[i].endpoint = (std::filesystem::temp_directory_path()
+                                    / std::format("webserver-php-{}-{}-{}.sock", ::getpid(), pool, i)).string();
+#endif
+        }
+        if (isSupported()) {
+            std::lock_guard<std::mutex> guard(mutex_);
+            for (auto& worker : workers_) {
+                spawn(worker);
+            }
+            scheduleReap();
+        } else {
+            Debug::Log::error("php-cgi worker pool is not supported on this platform", "PhpWorkerPool");
+        }
+        // The thread shares the io_context, the pool may be released from one of its own handlers
+        thread_ = std::thread([context = ioContext_]() {
+            try {
+                context->run();
+            } catch (const std::exception& e) {
+                Debug::Log::error(std::format("Worker pool error: {}", e.what()), "PhpWorkerPool");
+            }
+        });
+    }
+
+    PhpWorkerPool::~PhpWorkerPool() {
+        workGuard_.reset();
+        ioContext_->stop();
+        if (thread_.get_id() == std::this_thread::get_id()) {
+            thread_.detach();
+        } else if (thread_.joinable()) {
+            thread_.join();
+        }
+        reapTimer_.cancel();
+
+#ifndef _WIN32
+        // Ask every child to quit, then force the ones still running after a grace period
+        std::lock_guard<std::mutex> guard(mutex_);
+        for (auto& worker : workers_) {
+            terminate(worker);
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (!retired_.empty() && std::chrono::steady_clock::now() < deadline) {
+            std::erase_if(retired_, [](int pid) { return ::waitpid(pid, nullptr, WNOHANG) != 0; });
+            if (!retired_.empty()) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        for (int pid : retired_) {
+            ::kill(pid, SIGKILL);
+            ::waitpid(pid, nullptr, 0);
+        }
+        for (const auto& worker : workers_) {
+            std::error_code ec;
+            std::filesystem::remove(worker.endpoint, ec);
+        }
+#endif
+    }
+
+    bool PhpWorkerPool::isSupported() {
+#ifdef _WIN32
+        return false;
+#else
+        return true;
+#endif
+    }
+
+    bool PhpWorkerPool::acquire(Handler handler) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        queue_.push_back(std::move(handler));
+        dispatchQueued();
+        if (queue_.size() > settings_.queueSize) {
+            // Every child is busy and enough requests are already waiting
+            queue_.pop_back();
+            return false;
+        }
+        return true;
+    }
+
+    void PhpWorkerPool::release(const Lease& lease, bool failed) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        Worker& worker = workers_[lease.worker];
+        worker.busy = false;
+        ++worker.requests;
+        if (failed || worker.pid < 0 || worker.requests >= settings_.maxRequests) {
+            if (failed) {
+                Debug::Log::error(std::format("php-cgi worker {} failed, restarting it", lease.worker), "PhpWorkerPool");
+            }
+            terminate(worker);
+            spawn(worker);
+        }
+        dispatchQueued();
+    }
+
+    void PhpWorkerPool::dispatchQueued() {
+        auto now = std::chrono::steady_clock::now();
+        bool alive = false;
+        for (std::size_t i = 0; i < workers_.size() && !queue_.empty(); ++i) {
+            Worker& worker = workers_[i];
+            if (worker.pid < 0 && !worker.busy && now >= nextSpawnAttempt_) {
+                spawn(worker);
+            }
+            if (worker.pid < 0) {
+                continue;
+            }
+            alive = true;
+            if (worker.busy) {
+                continue;
+            }
+            worker.busy = true;
+            Lease lease{i, worker.endpoint, now - worker.started < startupWindow};
+            boost::asio::post(*ioContext_, [handler = std::move(queue_.front()), lease]() { handler(lease); });
+            queue_.pop_front();
+        }
+        if (!alive) {
+            // php-cgi cannot be started at all, fail the waiting requests instead of letting them hang
+            while (!queue_.empty()) {
+                boost::asio::post(*ioContext_, [handler = std::move(queue_.front())]() { handler(std::nullopt); });
+                queue_.pop_front();
+            }
+        }
+    }
+
+    bool PhpWorkerPool::spawn(Worker& worker) {
+#ifndef _WIN32
+        std::error_code ec;
+        std::filesystem::remove(worker.endpoint, ec);
+
+        // php-cgi must not fork its own children or exit on its own, the pool does both
+        std::vector<std::string> environment = {"PHP_FCGI_CHILDREN=0", "PHP_FCGI_MAX_REQUESTS=0"};
+        for (char** variable = environ; *variable; ++variable) {
+            if (!std::string_view(*variable).starts_with("PHP_FCGI_")) {
+                environment.emplace_back(*variable);
+            }
+        }
+        std::vector<char*> envp;
+        for (auto& variable : environment) envp.push_back(variable.data());
+        envp.push_back(nullptr);
+        std::string bindOption = "-b";
+        std::vector<char*> argv = {settings_.binary.data(), bindOption.data(), worker.endpoint.data(), nullptr};
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 34))
+        // Listening and client sockets must not leak into the child
+        posix_spawn_file_actions_addclosefrom_np(&actions, 3);
+#endif
+        pid_t pid = -1;
+        int result = ::posix_spawnp(&pid, settings_.binary.c_str(), &actions, nullptr, argv.data(), envp.data());
+        posix_spawn_file_actions_destroy(&actions);
+        if (result != 0) {
+            Debug::Log::error(std::format("Failed to start {}: {}", settings_.binary, std::strerror(result)), "PhpWorkerPool");
+            worker.pid = -1;
+            nextSpawnAttempt_ = std::chrono::steady_clock::now() + spawnBackoff;
+            return false;
+        }
+        worker.pid = pid;
+        worker.requests = 0;
+        worker.started = std::chrono::steady_clock::now();
+        Debug::Log::info(std::format("Started {} -b {} (pid {})", settings_.binary, worker.endpoint, pid), "PhpWorkerPool");
+        return true;
+#else
+        (void)worker;
+        return false;
+#endif
+    }
+
+    void PhpWorkerPool::terminate(Worker& worker) {
+#ifndef _WIN32
+        if (worker.pid > 0) {
+            ::kill(worker.pid, SIGTERM);
+            retired_.push_back(worker.pid); // Collected by reap()
+        }
+#endif
+        worker.pid = -1;
+    }
+
+    void PhpWorkerPool::scheduleReap() {
+        reapTimer_.expires_after(reapInterval);
+        reapTimer_.async_wait([this](const boost::system::error_code& error) {
+            if (error) {
+                return;
+            }
+            reap();
+            scheduleReap();
+        });
+    }
+
+    void PhpWorkerPool::reap() {
+#ifndef _WIN32
+        std::lock_guard<std::mutex> guard(mutex_);
+        std::erase_if(retired_, [](int pid) { return ::waitpid(pid, nullptr, WNOHANG) != 0; });
+        for (std::size_t i = 0; i < workers_.size(); ++i) {
+            Worker& worker = workers_[i];
+            int status = 0;
+            if (worker.pid > 0 && ::waitpid(worker.pid, &status, WNOHANG) == worker.pid) {
+                Debug::Log::error(std::format("php-cgi worker {} (pid {}) exited with status {}", i, worker.pid,
+                                              WIFEXITED(status) ? WEXITSTATUS(status) : -WTERMSIG(status)), "PhpWorkerPool");
+                worker.pid = -1;
+            }
+            // A busy child is replaced when its request fails and the lease comes back
+            if (worker.pid < 0 && !worker.busy && std::chrono::steady_clock::now() >= nextSpawnAttempt_) {
+                spawn(worker);
+            }
+        }
+        dispatchQueued();
+#endif
+    }
+
+} // System
\ No newline at end of file
@@ -0,0 +1,95 @@
+#ifndef WEBSERVER_PHPWORKERPOOL_H
+#define WEBSERVER_PHPWORKERPOOL_H
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace System {
+
+    // Long-lived `php-cgi -b <socket>` FastCGI children of one project. Each child serves one
+    // request at a time; requests wait in a bounded queue while all children are busy. Children
+    // are recycled after maxRequests and respawned when they exit. POSIX only.
+    class PhpWorkerPool {
+    public:
+        struct Settings {
+            std::string binary = "php-cgi";
+            int workers = 4;
+            int maxRequests = 500;     // Requests per child before it is replaced
+            std::size_t queueSize = 64; // Requests allowed to wait for a child
+
+            bool operator==(const Settings&) const = default;
+        };
+
+        // A child leased for one request
+        struct Lease {
+            std::size_t worker = 0;
+            std::string endpoint; // Unix socket the child listens on
+            bool starting = false; // Spawned moments ago, its socket may not be bound yet
+        };
+
+        // Called on the pool's thread with a child, or empty if none could be started
+        using Handler = std::function<void(std::optional<Lease>)>;
+
+        explicit PhpWorkerPool(Settings settings);
+        ~PhpWorkerPool();
+
+        PhpWorkerPool(const PhpWorkerPool&) = delete;
+        PhpWorkerPool& operator=(const PhpWorkerPool&) = delete;
+
+        static bool isSupported();
+
+        const Settings& getSettings() const { return settings_; }
+
+        // Context on which leases are handed out, FastCGI I/O with the children runs here too
+        boost::asio::io_context& getIoContext() { return *ioContext_; }
+
+        // Lease an idle child, queued while all are busy. False when the queue is full
+        bool acquire(Handler handler);
+
+        // Return a child, failed replaces it (crashed or broken connection)
+        void release(const Lease& lease, bool failed);
+
+    private:
+        struct Worker {
+            int pid = -1;
+            std::string endpoint;
+            int requests = 0;
+            bool busy = false;
+            std::chrono::steady_clock::time_point started;
+        };
+
+        // Start a child on the worker's socket, false if the binary cannot be run
+        bool spawn(Worker& worker);
+        void terminate(Worker& worker);
+
+        // Hand idle children to queued requests, caller holds mutex_
+        void dispatchQueued();
+
+        // Periodically collect exited children and start replacements
+        void scheduleReap();
+        void reap();
+
+        Settings settings_;
+        std::shared_ptr<boost::asio::io_context> ioContext_; // Shared with thread_, which may outlive the pool
+        boost::asio::executor_work_guard<boost::asio::io_context::executor_type> workGuard_;
+        boost::asio::steady_timer reapTimer_;
+        std::thread thread_;
+        std::mutex mutex_;
+        std::vector<Worker> workers_;
+        std::deque<Handler> queue_;
+        std::vector<int> retired_; // Terminated children not collected yet
+        std::chrono::steady_clock::time_point nextSpawnAttempt_; // Back-off after a failed spawn
+    };
+
+} // System
+
+#endif //WEBSERVER_PHPWORKERPOOL_H
\ No newline at end of file
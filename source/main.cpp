@@ -1,4 +1,6 @@
-﻿#include <filesystem>
+﻿#include <deque>
+#include <filesystem>
+#include <set>
 #include <vector>
 #include <string>
 #include <imgui.h>
@@ -7,6 +9,7 @@
 #include <GLFW/glfw3.h>
 #include "Network/WebServer.h"
 #include "Debug/Log.h"
+#include "Debug/LogBuffer.h"
 #include "System/HtaccessConfig.h"
 #include <nlohmann/json.hpp>
 
@@ -50,6 +53,108 @@ std::string getDomainsPath(const std::string& exeDir) {
     return (std::filesystem::path(exeDir) / "domains").string();
 }
 
+// The GUI thread's copy of the recent log lines and the filter applied to them
+struct LogView {
+    std::deque<Debug::LogBuffer::Record> records;
+    std::deque<const Debug::LogBuffer::Record*> visible; // Records passing the filter, in order
+    std::set<std::string> sources; // Every source seen, for the filter combo
+    std::uint64_t next = 0; // Sequence to copy from next frame
+    bool levels[4] = {true, true, true, true}; // Debug, Info, Warning, Error
+    std::string source; // Only this source when not empty
+    bool autoScroll = true;
+
+    bool matches(const Debug::LogBuffer::Record& record) const {
+        return levels[static_cast<int>(record.level)] && (source.empty() || record.source == source);
+    }
+
+    void refilter() {
+        visible.clear();
+        for (const auto& record : records) {
+            if (matches(record)) visible.push_back(&record);
+        }
+    }
+
+    // Take the lines added since the last frame, only locking the buffer when there are any
+    void update(const Debug::LogBuffer& buffer) {
+        if (buffer.getSequence() == next) return;
+        std::vector<Debug::LogBuffer::Record> added;
+        next = buffer.copySince(next, added);
+        for (auto& record : added) {
+            if (records.size() == buffer.capacity()) {
+                if (!visible.empty() && visible.front() == &records.front()) visible.pop_front();
+                records.pop_front();
+            }
+            if (!record.source.empty()) sources.insert(record.source);
+            records.push_back(std::move(record));
+            if (matches(records.back())) visible.push_back(&records.back());
+        }
+    }
+
+    void draw() {
+        // Lines below the runtime level are not logged at all, the checkboxes only hide lines
+        static const char* levelNames[] = {"Debug", "Info", "Warning", "Error"};
+        int level = static_cast<int>(Debug::Log::getLevel());
+        ImGui::SetNextItemWidth(100);
+        if (ImGui::Combo("Log level", &level, levelNames, IM_ARRAYSIZE(levelNames))) {
+            Debug::Log::setLevel(static_cast<Debug::Log::Level>(level));
+        }
+
+        bool changed = false;
+        changed |= ImGui::Checkbox("Debug", &levels[0]);
+        ImGui::SameLine();
+        changed |= ImGui::Checkbox("Info", &levels[1]);
+        ImGui::SameLine();
+        changed |= ImGui::Checkbox("Warnings", &levels[2]);
+        ImGui::SameLine();
+        changed |= ImGui::Checkbox("Errors", &levels[3]);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(160);
+        if (ImGui::BeginCombo("Source", source.empty() ? "All" : source.c_str())) {
+            if (ImGui::Selectable("All", source.empty())) {
+                source.clear();
+                changed = true;
+            }
+            for (const auto& name : sources) {
+                if (ImGui::Selectable(name.c_str(), name == source)) {
+                    source = name;
+                    changed = true;
+                }
+            }
+            ImGui::EndCombo();
+        }
+        ImGui::SameLine();
+        ImGui::Checkbox("Auto-scroll", &autoScroll);
+        ImGui::SameLine();
+        if (ImGui::Button("Clear")) {
+            records.clear();
+            visible.clear();
+        }
+        if (changed) refilter();
+
+        ImGui::BeginChild("LogLines", ImVec2(0, 0), ImGuiChildFlags_None, ImGuiWindowFlags_HorizontalScrollbar);
+        // Only the lines in view are submitted
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(visible.size()));
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+                const auto& record = *visible[static_cast<std::size_t>(i)];
+                if (record.level == Debug::Log::Level::Error) {
+                    ImGui::TextColored(ImVec4(1, 0.4f, 0.4f, 1), "%s", record.text.c_str());
+                } else if (record.level == Debug::Log::Level::Warning) {
+                    ImGui::TextColored(ImVec4(1, 0.8f, 0.3f, 1), "%s", record.text.c_str());
+                } else {
+                    ImGui::TextUnformatted(record.text.c_str());
+                }
+            }
+        }
+        clipper.End();
+        if (autoScroll && ImGui::GetScrollY() >= ImGui::GetScrollMaxY()) {
+            ImGui::SetScrollHereY(1.0f);
+        }
+        ImGui::EndChild();
+    }
+};
+
 static void glfw_error_callback(int error, const char* description) {
     Debug::Log::error(std::format("GLFW Error {}: {}", error, description), "GLFW");
 }
@@ -117,6 +222,7 @@ int main() {
 
     // Main loop
     bool serverRunning = false;
+    LogView logView;
     while (!glfwWindowShouldClose(window)) {
         glfwPollEvents();
         ImGui_ImplOpenGL3_NewFrame();
@@ -148,6 +254,72 @@ int main() {
 
         ImGui::Separator();
 
+        // Worker pool size, applied on the next start
+        ImGui::BeginDisabled(serverRunning);
+        int threadCount = static_cast<int>(server.getThreadCount());
+        if (ImGui::InputInt("Worker threads", &threadCount) && threadCount > 0) {
+            server.setThreadCount(static_cast<std::size_t>(threadCount));
+        }
+        bool sharded = server.isSharded();
+        if (ImGui::Checkbox("Sharded (io_context and SO_REUSEPORT acceptor per thread)", &sharded)) {
+            server.setSharded(sharded);
+        }
+        ImGui::EndDisabled();
+
+        Network::WebServer::PoolStats poolStats = server.getPoolStats();
+        ImGui::Text("Pool: %zu threads, %llu queued, %llu active, %llu completed",
+                    poolStats.threads,
+                    static_cast<unsigned long long>(poolStats.queued),
+                    static_cast<unsigned long long>(poolStats.active),
+                    static_cast<unsigned long long>(poolStats.completed));
+
+        // Per-shard counters show how evenly the kernel balances accepts
+        std::vector<Network::WebServer::ShardStats> shardStats = server.getShardStats();
+        for (std::size_t i = 0; i < shardStats.size(); ++i) {
+            ImGui::Text("Shard %zu: %llu connections, %llu requests", i,
+                        static_cast<unsigned long long>(shardStats[i].connections),
+                        static_cast<unsigned long long>(shardStats[i].requests));
+        }
+
+        ImGui::Separator();
+
+        // Static file cache
+        System::FileCache::Stats cacheStats = server.getFileCache().getStats();
+        int cacheBudgetMb = static_cast<int>(cacheStats.byteBudget / (1024 * 1024));
+        if (ImGui::InputInt("File cache (MB)", &cacheBudgetMb) && cacheBudgetMb >= 0) {
+            server.getFileCache().setByteBudget(static_cast<std::size_t>(cacheBudgetMb) * 1024 * 1024);
+        }
+        ImGui::Text("Cache: %zu files, %zu KB, %llu hits, %llu misses, %llu evictions",
+                    cacheStats.entries, cacheStats.bytes / 1024,
+                    static_cast<unsigned long long>(cacheStats.hits),
+                    static_cast<unsigned long long>(cacheStats.misses),
+                    static_cast<unsigned long long>(cacheStats.evictions));
+
+        // PHP responses kept by projects with MicroCache set
+        Network::MicroCache::Stats microStats = server.getMicroCacheStats();
+        ImGui::Text("Microcache: %zu responses, %zu KB, %llu hits, %llu misses, %llu stale, %llu coalesced",
+                    microStats.entries, microStats.bytes / 1024,
+                    static_cast<unsigned long long>(microStats.hits),
+                    static_cast<unsigned long long>(microStats.misses),
+                    static_cast<unsigned long long>(microStats.stale),
+                    static_cast<unsigned long long>(microStats.coalesced));
+
+        ImGui::Separator();
+
+        // PHP interpreter located at startup
+        auto php = server.getPhpInterpreter().get();
+        if (php->isAvailable()) {
+            ImGui::Text("PHP %s: %s", php->version.empty() ? "(unknown version)" : php->version.c_str(), php->path.c_str());
+        } else {
+            ImGui::TextColored(ImVec4(1, 0, 0, 1), "PHP: not found in PATH");
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Probe PHP")) {
+            server.getPhpInterpreter().reprobe(true);
+        }
+
+        ImGui::Separator();
+
         if (ImGui::CollapsingHeader("Projects", ImGuiTreeNodeFlags_DefaultOpen)) {
             ImGui::BeginChild("ProjectsList", ImVec2(0, 150), true);
             for (const auto& [port, path] : server.getProjects()) {
@@ -158,10 +330,9 @@ int main() {
         ImGui::End();
 
         // Log window
+        logView.update(Debug::Log::getBuffer());
         ImGui::Begin("Logs");
-        for (const auto& log : Debug::Log::logs) {
-            ImGui::TextUnformatted(log.c_str());
-        }
+        logView.draw();
         ImGui::End();
 
         ImGui::Render();